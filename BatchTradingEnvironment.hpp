@@ -0,0 +1,130 @@
+#ifndef __BATCH_TRADING_ENVIRONMENT_H
+#define __BATCH_TRADING_ENVIRONMENT_H
+
+// N independent portfolios trading one price series in lockstep.
+//
+// Portfolio state is kept as structure-of-arrays: cash[N], and holdings as
+// one row of N per stock. Every portfolio is at the same step, so a step
+// reads one price per stock and then applies buy/sell/hold to all N
+// portfolios in a branch-free loop over contiguous arrays. Stock i trades
+// at column i of the market data, as in TradingEnvironment.
+
+#include "MarketData.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+enum class Action : std::int32_t { Buy, Sell, Hold };
+
+class BatchTradingEnvironment {
+public:
+    // data must outlive the environment; its columns are read in place
+    BatchTradingEnvironment(const MarketData& data, std::size_t num_portfolios, int num_stocks, double initial_cash)
+        : num_portfolios_(num_portfolios), num_stocks_(num_stocks), initial_cash_(initial_cash),
+          rows_(static_cast<int>(data.rows())) {
+        if (num_stocks < 1 || static_cast<std::size_t>(num_stocks) > data.columns())
+            throw std::invalid_argument("BatchTradingEnvironment: num_stocks must be between 1 and the number of columns");
+        if (rows_ == 0) throw std::invalid_argument("BatchTradingEnvironment: no market data rows");
+        for (int i = 0; i < num_stocks; i++) columns_.push_back(data.column(i));
+
+        cash_.resize(num_portfolios);
+        values_.resize(num_portfolios);
+        rewards_.resize(num_portfolios);
+        holdings_.resize(num_portfolios * num_stocks);
+        prices_.resize(num_stocks);
+        returns_.resize(num_stocks);
+        reset();
+    }
+
+    void reset() {
+        current_step_ = 0;
+        loadPrices();
+        std::fill(cash_.begin(), cash_.end(), initial_cash_);
+        std::fill(values_.begin(), values_.end(), initial_cash_);
+        std::fill(rewards_.begin(), rewards_.end(), 0.0);
+        std::fill(holdings_.begin(), holdings_.end(), 0);
+    }
+
+    // Advances every portfolio by one step. actions holds one Action per
+    // (stock, portfolio), stock-major: actions[i * size() + p]. Rewards are
+    // the relative change in portfolio value over the step.
+    void step(const Action* actions) {
+        current_step_++;
+        if (current_step_ >= rows_) {
+            std::fill(rewards_.begin(), rewards_.end(), 0.0);
+            return;
+        }
+        loadPrices();
+
+        const std::size_t n = num_portfolios_;
+        double* cash = cash_.data();
+        for (int i = 0; i < num_stocks_; i++) {
+            const double price = prices_[i];
+            const Action* a = actions + i * n;
+            std::int32_t* h = holdings_.data() + i * n;
+            for (std::size_t p = 0; p < n; p++) {
+                std::int32_t code = static_cast<std::int32_t>(a[p]);
+                std::int32_t buy = (code == static_cast<std::int32_t>(Action::Buy)) & (cash[p] >= price);
+                std::int32_t sell = (code == static_cast<std::int32_t>(Action::Sell)) & (h[p] > 0);
+                h[p] += buy - sell;
+                cash[p] += static_cast<double>(sell - buy) * price;
+            }
+        }
+
+        double* value = rewards_.data();  // New values, turned into rewards below
+        for (std::size_t p = 0; p < n; p++) value[p] = cash[p];
+        for (int i = 0; i < num_stocks_; i++) {
+            const double price = prices_[i];
+            const std::int32_t* h = holdings_.data() + i * n;
+            for (std::size_t p = 0; p < n; p++) value[p] += h[p] * price;
+        }
+        for (std::size_t p = 0; p < n; p++) {
+            double previous = values_[p];
+            values_[p] = value[p];
+            rewards_[p] = (value[p] - previous) / previous;
+        }
+    }
+
+    bool isTerminal() const { return current_step_ >= rows_ - 1; }
+
+    std::size_t size() const { return num_portfolios_; }
+    int stocks() const { return num_stocks_; }
+    int currentStep() const { return current_step_; }
+    int rows() const { return rows_; }
+
+    // Per-portfolio arrays, size() long
+    const double* cash() const { return cash_.data(); }
+    const double* values() const { return values_.data(); }
+    const double* rewards() const { return rewards_.data(); }
+    const std::int32_t* holdings(int stock) const { return holdings_.data() + stock * num_portfolios_; }
+
+    // Shared by every portfolio: current price of each stock and its return
+    // over the previous step (0 at the first step)
+    const double* prices() const { return prices_.data(); }
+    const double* returns() const { return returns_.data(); }
+
+private:
+    void loadPrices() {
+        for (int i = 0; i < num_stocks_; i++) {
+            prices_[i] = columns_[i][current_step_];
+            returns_[i] = current_step_ > 0 ? prices_[i] / columns_[i][current_step_ - 1] - 1.0 : 0.0;
+        }
+    }
+
+    std::size_t num_portfolios_;
+    int num_stocks_;
+    double initial_cash_;
+    int rows_;
+    int current_step_ = 0;
+    std::vector<ColumnView<double>> columns_;
+    std::vector<double> cash_;
+    std::vector<double> values_;
+    std::vector<double> rewards_;
+    std::vector<std::int32_t> holdings_;  // Stock-major: holdings_[i * N + p]
+    std::vector<double> prices_;
+    std::vector<double> returns_;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef __CONTINUOUS_Q_MODEL_H
+#define __CONTINUOUS_Q_MODEL_H
+
+// Action-value model for continuous states and actions, by hashed tile
+// coding.
+//
+// The joint input (state features, action) is covered by `tilings` grids of
+// `tiles_per_dim` tiles per dimension, each grid offset a fraction of a tile
+// from the last. Q(s, a) is the sum of one weight per grid, the weight of the
+// tile the input falls in. Tiles are hashed into a fixed table of weights, so
+// memory is set at construction and evaluating or updating Q costs `tilings`
+// lookups, however many states and actions have been seen. Nearby inputs
+// share tiles, so what is learnt for one action generalises to its
+// neighbours.
+//
+// Inputs are expected in [0, 1] and clamped to it.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct TileCodingOptions {
+    int tilings = 8;
+    int tiles_per_dim = 8;
+    std::size_t table_size = 1 << 16;  // Weights; a power of two
+    double learning_rate = 0.1;        // Step size of one update, shared across tilings
+};
+
+class ContinuousQModel {
+public:
+    // Candidate actions per block in values(); the per-block scratch stays on the stack
+    static constexpr std::size_t BLOCK = 64;
+
+    ContinuousQModel(int state_dims, int action_dims, const TileCodingOptions& options = TileCodingOptions())
+        : state_dims_(state_dims), action_dims_(action_dims), options_(options),
+          weights_(options.table_size, 0.0) {
+        if (state_dims < 0 || action_dims < 1)
+            throw std::invalid_argument("ContinuousQModel needs at least one action dimension");
+        if (options.tilings < 1 || options.tilings > MAX_TILINGS || options.tiles_per_dim < 1)
+            throw std::invalid_argument("ContinuousQModel needs 1 to " + std::to_string(MAX_TILINGS) +
+                                        " tilings and at least one tile per dimension");
+        if (options.table_size == 0 || (options.table_size & (options.table_size - 1)) != 0)
+            throw std::invalid_argument("ContinuousQModel table_size must be a power of two");
+    }
+
+    double value(const double* state, const double* action) const {
+        double q;
+        values(state, action, 1, &q);
+        return q;
+    }
+
+    // out[c] = Q(state, actions + c * action_dims()) for c < n. Candidates
+    // are processed a block at a time with the candidate loop innermost, so
+    // the tile arithmetic vectorizes; only the weight loads are gathers.
+    void values(const double* state, const double* actions, std::size_t n, double* out) const {
+        std::uint64_t hash[BLOCK];
+        std::uint64_t state_hash[MAX_TILINGS];
+        const int tilings = options_.tilings;
+
+        for (int k = 0; k < tilings; ++k) state_hash[k] = hashState(state, k);
+
+        for (std::size_t base = 0; base < n; base += BLOCK) {
+            const std::size_t m = std::min(BLOCK, n - base);
+            const double* a = actions + base * action_dims_;
+            for (std::size_t c = 0; c < m; ++c) out[base + c] = 0.0;
+
+            for (int k = 0; k < tilings; ++k) {
+                for (std::size_t c = 0; c < m; ++c) hash[c] = state_hash[k];
+                for (int d = 0; d < action_dims_; ++d) {
+                    const double offset = tileOffset(k, state_dims_ + d);
+                    for (std::size_t c = 0; c < m; ++c) {
+                        hash[c] = mix(hash[c], tileCoordinate(a[c * action_dims_ + d], offset));
+                    }
+                }
+                for (std::size_t c = 0; c < m; ++c) out[base + c] += weights_[slot(hash[c])];
+            }
+        }
+    }
+
+    // Moves Q(state, action) towards target by learning_rate of the error
+    void update(const double* state, const double* action, double target) {
+        std::size_t slots[MAX_TILINGS];
+        const int tilings = options_.tilings;
+        double q = 0.0;
+        for (int k = 0; k < tilings; ++k) {
+            std::uint64_t h = hashState(state, k);
+            for (int d = 0; d < action_dims_; ++d) h = mix(h, tileCoordinate(action[d], tileOffset(k, state_dims_ + d)));
+            slots[k] = slot(h);
+            q += weights_[slots[k]];
+        }
+        const double step = options_.learning_rate / tilings * (target - q);
+        for (int k = 0; k < tilings; ++k) weights_[slots[k]] += step;
+    }
+
+    // update() for samples i < n in order, with state i at states + i * stateDims()
+    // and action i at actions + i * actionDims()
+    void update(const double* states, const double* actions, const double* targets, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            update(states + i * state_dims_, actions + i * action_dims_, targets[i]);
+        }
+    }
+
+    int stateDims() const { return state_dims_; }
+    int actionDims() const { return action_dims_; }
+    std::size_t memoryBytes() const { return weights_.size() * sizeof(double); }
+
+private:
+    static constexpr int MAX_TILINGS = 64;
+
+    // Tiling k is displaced by k / tilings of a tile along dimension d,
+    // times an odd factor per dimension so the grids do not line up diagonally
+    double tileOffset(int k, int d) const {
+        return static_cast<double>((k * (2 * d + 1)) % options_.tilings) / options_.tilings;
+    }
+
+    std::int64_t tileCoordinate(double x, double offset) const {
+        x = x < 0.0 ? 0.0 : x > 1.0 ? 1.0 : x;
+        return static_cast<std::int64_t>(x * options_.tiles_per_dim + offset);
+    }
+
+    std::uint64_t hashState(const double* state, int k) const {
+        std::uint64_t h = 0x9e3779b97f4a7c15ULL * static_cast<std::uint64_t>(k + 1);
+        for (int d = 0; d < state_dims_; ++d) h = mix(h, tileCoordinate(state[d], tileOffset(k, d)));
+        return h;
+    }
+
+    static std::uint64_t mix(std::uint64_t h, std::int64_t coordinate) {
+        return (h ^ static_cast<std::uint64_t>(coordinate)) * 0xff51afd7ed558ccdULL;
+    }
+
+    std::size_t slot(std::uint64_t h) const {
+        return static_cast<std::size_t>((h ^ (h >> 29)) & (weights_.size() - 1));
+    }
+
+    int state_dims_;
+    int action_dims_;
+    TileCodingOptions options_;
+    std::vector<double> weights_;
+};
+
+#endif
@@ -0,0 +1,27 @@
+// Converts yfinance CSVs to the binary columnar format read by MarketData.
+//
+// Build:
+//   clang++ -std=c++17 -O2 ConvertMarketData.cpp -o ConvertMarketData
+// Usage:
+//   ./ConvertMarketData AAPL_1y_1d.csv [more.csv ...]   writes AAPL_1y_1d.csv.col, ...
+#include "MarketData.hpp"
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " file.csv [file.csv ...]" << std::endl;
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        std::string csv_path = argv[i];
+        try {
+            convert_market_data(csv_path, csv_path + ".col");
+            MarketData data(csv_path + ".col");
+            std::cout << csv_path << ".col: " << data.rows() << " rows, " << data.columns() << " columns" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include "ImpliedVol.hpp"
+#include "NormalDistribution.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+// The solver works on Jaeckel's normalised Black price
+//   b(x, s) = e^{x/2} N(x/s + s/2) - e^{-x/2} N(x/s - s/2)
+// with x = ln(F/K) and s = sigma * sqrt(T), i.e. the undiscounted call price
+// divided by sqrt(F K). Puts and in-the-money calls are mapped to the
+// out-of-the-money call at -|x| by put-call parity, so x <= 0 throughout.
+
+namespace {
+
+// Quotes per inner block, as in VanillaBatch.cpp
+const std::size_t BLOCK = 256;
+
+const std::size_t PARALLEL_THRESHOLD = 4096;
+
+// A step below this fraction of s counts as converged. Tighter is pointless:
+// rounding in b limits the attainable accuracy to about 1e-12 for small s.
+const double TOLERANCE = 1e-12;
+
+const double INV_SQRT_2PI = 0.398942280401432678;
+
+// ln(x) for finite x > 0 by exponent extraction and the atanh series on
+// [sqrt(1/2), sqrt(2)]. Inline and branch-free so the solver loop vectorizes.
+inline double log_positive(double x) {
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+
+    std::int64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    std::int64_t exponent = ((bits >> 52) & 0x7ff) - 1023;
+    bits = (bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL;
+    double m;
+    std::memcpy(&m, &bits, sizeof(m));
+
+    bool high = m > M_SQRT2;
+    m = high ? 0.5 * m : m;
+    double e = static_cast<double>(exponent) + (high ? 1.0 : 0.0);
+
+    double f = (m - 1.0) / (m + 1.0);
+    double f2 = f * f;
+    double p = 1.0 / 23;
+#pragma GCC unroll 11
+    for (int k = 21; k >= 1; k -= 2) p = 1.0 / k + f2 * p;
+    return (e * LN2_HI + 2.0 * f * p) + e * LN2_LO;
+}
+
+// Normalised out-of-the-money call price, x <= 0
+inline double normalised_call(double x, double s, double e_half, double e_neg_half) {
+    double h = x / s, t = 0.5 * s;
+    return e_half * norm_cdf(h + t) - e_neg_half * norm_cdf(h - t);
+}
+
+// Starting points for the iteration. Above the inflection point
+// s_c = sqrt(2|x|) of b, and below it while its discriminant is positive,
+// Corrado-Miller is within a few percent. Further out of the money the
+// small-s asymptote
+//   ln b ~ 3 ln s - 2 ln|x| - ln(2 pi)/2 - x^2/(2 s^2) - s^2/8
+// is solved by fixed-point iteration instead.
+inline double corrado_miller(double b, double e_neg_half, double& disc) {
+    double k = e_neg_half * e_neg_half;
+    double a = b * e_neg_half - 0.5 * (1.0 - k);
+    disc = a * a - (1.0 - k) * (1.0 - k) / M_PI;
+    return std::sqrt(2.0 * M_PI) / (1.0 + k) * (a + std::sqrt(std::max(0.0, disc)));
+}
+
+inline double small_s_asymptote(double x, double ln_b, double s_c) {
+    double A = -ln_b - 0.5 * std::log(2.0 * M_PI) - 2.0 * log_positive(-x);
+    double s = s_c;
+    for (int i = 0; i < 3; ++i) {
+        double den = std::max(A + 3.0 * log_positive(s) - 0.125 * s * s, 1e-300);
+        s = std::min(s_c, -x / std::sqrt(2.0 * den));
+    }
+    return s;
+}
+
+void solve_range(const QuoteBatch& quotes, double* sigma, std::size_t begin, std::size_t end) {
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+    double x[BLOCK], b[BLOCK], ln_b[BLOCK], e_half[BLOCK], e_neg_half[BLOCK];
+    double s_c[BLOCK], s_far[BLOCK], s[BLOCK], lo[BLOCK], hi[BLOCK];
+    // Per-lane flags, 0 or 1, kept as doubles so the masked updates below
+    // stay in one vector width
+    double low[BLOCK], done[BLOCK];
+
+    for (std::size_t base = begin; base < end; base += BLOCK) {
+        const std::size_t n = std::min(BLOCK, end - base);
+        const double* K = quotes.K + base;
+        const double* T = quotes.T + base;
+        const double* r = quotes.r + base;
+        const double* S = quotes.S + base;
+        const double* price = quotes.price + base;
+        const bool* is_call = quotes.is_call + base;
+
+        // Normalise and reduce to an out-of-the-money call
+        for (std::size_t i = 0; i < n; ++i) {
+            double log_moneyness = std::log(S[i] / K[i]) + r[i] * T[i];
+            double beta = price[i] * std::exp(0.5 * r[i] * T[i]) / std::sqrt(S[i] * K[i]);
+
+            double x_i = -std::fabs(log_moneyness);
+            e_half[i] = std::exp(0.5 * x_i);
+            e_neg_half[i] = 1.0 / e_half[i];
+            bool in_the_money = is_call[i] ? log_moneyness > 0.0 : log_moneyness < 0.0;
+            double b_i = in_the_money ? beta - (e_neg_half[i] - e_half[i]) : beta;
+
+            x[i] = x_i;
+            b[i] = b_i;
+            bool valid = b_i > std::numeric_limits<double>::min() && b_i < e_half[i] && T[i] > 0.0;
+            done[i] = valid ? 0.0 : 1.0;
+        }
+
+        // Starting points. Each candidate gets its own loop so every loop
+        // stays simple enough to vectorize; invalid lanes are evaluated too
+        // and discarded.
+        for (std::size_t i = 0; i < n; ++i) {
+            ln_b[i] = log_positive(b[i]);
+            s_c[i] = std::sqrt(-2.0 * x[i]);
+            double b_c = normalised_call(x[i], s_c[i], e_half[i], e_neg_half[i]);
+            low[i] = (x[i] < 0.0) & (b[i] < b_c) ? 1.0 : 0.0;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            s_far[i] = small_s_asymptote(x[i], ln_b[i], s_c[i]);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            double disc;
+            double s_cm = corrado_miller(b[i], e_neg_half[i], disc);
+            double below = disc >= 0.0 ? std::min(s_cm, s_c[i]) : s_far[i];
+            double guess = low[i] != 0.0 ? below : std::max(s_cm, s_c[i]);
+            s[i] = done[i] != 0.0 ? NaN : guess > 0.0 ? guess : 1.0;
+            lo[i] = 0.0;
+            hi[i] = std::numeric_limits<double>::infinity();
+        }
+
+        // Householder steps of order 3 with analytic vega, on b - beta above
+        // the inflection point and on ln b - ln beta below it, where the
+        // price objective is too convex. Each step is kept inside the
+        // bracket established so far and falls back to bisection otherwise.
+        // Converged lanes are masked rather than branched around so the
+        // loop stays vectorizable.
+        for (int iteration = 0; iteration < IMPLIED_VOL_MAX_ITERATIONS; ++iteration) {
+            int active = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                double s_i = s[i], x_i = x[i];
+                double h = x_i / s_i, t = 0.5 * s_i;
+                double price_i = e_half[i] * norm_cdf(h + t) - e_neg_half[i] * norm_cdf(h - t);
+                double vega = INV_SQRT_2PI * normal_detail::exp_nonpositive<13>(-0.5 * (h * h + t * t));
+                double f = price_i - b[i];
+
+                double lo_i = f < 0.0 ? std::max(lo[i], s_i) : lo[i];
+                double hi_i = f > 0.0 ? std::min(hi[i], s_i) : hi[i];
+
+                // b''/b' and b'''/b' in s
+                double x2_s3 = x_i * x_i / (s_i * s_i * s_i);
+                double g2 = x2_s3 - 0.25 * s_i;
+                double g3 = g2 * g2 - 3.0 * x2_s3 / s_i - 0.25;
+                double nu = -f / vega;
+
+                // The same ratios for ln b
+                double q = vega / std::max(price_i, std::numeric_limits<double>::min());
+                double g2_log = g2 - q;
+                double g3_log = g3 - 3.0 * q * g2 + 2.0 * q * q;
+                double nu_log = -(log_positive(std::max(price_i, std::numeric_limits<double>::min())) - ln_b[i]) / q;
+
+                bool use_log = low[i] != 0.0;
+                nu = use_log ? nu_log : nu;
+                g2 = use_log ? g2_log : g2;
+                g3 = use_log ? g3_log : g3;
+                double step = nu * (1.0 + 0.5 * g2 * nu) / (1.0 + nu * (g2 + g3 * nu / 6.0));
+
+                double next = s_i + step;
+                bool converged = std::fabs(step) <= TOLERANCE * s_i;
+                bool bracketed = next >= lo_i && next <= hi_i;
+                double fallback = hi_i < std::numeric_limits<double>::infinity() ? 0.5 * (lo_i + hi_i) : 2.0 * s_i;
+                next = bracketed || converged ? next : fallback;
+
+                bool was_done = done[i] != 0.0;
+                s[i] = was_done ? s_i : next;
+                lo[i] = was_done ? lo[i] : lo_i;
+                hi[i] = was_done ? hi[i] : hi_i;
+                done[i] = was_done || converged ? 1.0 : 0.0;
+                active += was_done || converged ? 0 : 1;
+            }
+            if (active == 0) break;
+        }
+
+        for (std::size_t i = 0; i < n; ++i) sigma[base + i] = s[i] / std::sqrt(T[i]);
+    }
+}
+
+} // namespace
+
+void batch_implied_vol(const QuoteBatch& quotes, double* sigma, unsigned n_threads) {
+    if (quotes.size == 0) return;
+
+    if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (quotes.size < PARALLEL_THRESHOLD) n_threads = 1;
+
+    // Contiguous, block-aligned slices; the calling thread takes the first
+    std::size_t n_blocks = (quotes.size + BLOCK - 1) / BLOCK;
+    n_threads = static_cast<unsigned>(std::min<std::size_t>(n_threads, n_blocks));
+    auto slice_begin = [&](unsigned t) {
+        return std::min(quotes.size, n_blocks * t / n_threads * BLOCK);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+    for (unsigned t = 1; t < n_threads; ++t) {
+        workers.emplace_back(solve_range, std::cref(quotes), sigma, slice_begin(t), slice_begin(t + 1));
+    }
+    solve_range(quotes, sigma, 0, slice_begin(1));
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+double implied_vol(double price, bool is_call, double K, double T, double r, double S) {
+    QuoteBatch quote{&K, &T, &r, &S, &price, &is_call, 1};
+    double sigma;
+    solve_range(quote, &sigma, 0, 1);
+    return sigma;
+}
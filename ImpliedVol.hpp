@@ -0,0 +1,32 @@
+#ifndef __IMPLIED_VOL_H
+#define __IMPLIED_VOL_H
+
+#include <cstddef>
+
+// Structure-of-arrays view of observed option quotes. Entry i is the price
+// of a European option on Vanilla(K[i], T[i], r[i], S[i], sigma) whose
+// volatility sigma is unknown.
+struct QuoteBatch {
+    const double* K;      // Strike prices
+    const double* T;      // Times to expiration (years)
+    const double* r;      // Risk-free interest rates
+    const double* S;      // Underlying asset prices
+    const double* price;  // Observed option prices
+    const bool* is_call;  // true for calls, false for puts
+    std::size_t size;
+};
+
+// Upper bound on solver iterations per quote, so the latency of a batch is
+// bounded whatever the quotes. Typical quotes converge in 3.
+const int IMPLIED_VOL_MAX_ITERATIONS = 8;
+
+// Black-Scholes implied volatility for every quote: sigma[i] reproduces
+// price[i] through Vanilla::calc_call_price / calc_put_price. Quotes outside
+// the no-arbitrage bounds, or whose time value underflows, give NaN.
+// n_threads = 0 uses every hardware thread.
+void batch_implied_vol(const QuoteBatch& quotes, double* sigma, unsigned n_threads = 0);
+
+// Single quote, same solver and results as the batch path
+double implied_vol(double price, bool is_call, double K, double T, double r, double S);
+
+#endif
@@ -1,6 +1,5 @@
 #include <iostream>
 #include <vector>
-#include <map>
 #include <random>
 #include <algorithm>
 #include <fstream>
@@ -8,11 +7,21 @@
 #include <cmath>
 #include <numeric>
 #include <iomanip>
+#include "ContinuousQModel.hpp"
+#include "RiskMetrics.hpp"
 
 
+// Continuous actions in [0, 1] per stock, valued by a tile-coded model of
+// fixed size instead of a table of exact action vectors. The greedy action is
+// the best of a fresh set of random candidates, evaluated in one batch.
 class MonteCarloAgent {
 private:
-    std::map<State, std::vector<std::pair<std::vector<double>, double>>> Q;
+    // State features per stock: return since the last step and share of the
+    // portfolio held in it, plus the cash share; all scaled to [0, 1]
+    static const int FEATURES_PER_STOCK = 2;
+    static const int ACTION_CANDIDATES = 64;
+
+    ContinuousQModel model;
     std::mt19937 gen;
     std::uniform_real_distribution<> dis;
 
@@ -20,31 +29,53 @@ private:
     double epsilon_end;
     double epsilon_decay;
     double gamma;
-    double learning_rate;
     int num_stocks;
     int total_episodes;
     int current_episode;
 
+    std::vector<double> features;
+    std::vector<double> candidates;
+    std::vector<double> candidate_values;
+
 public:
-    MonteCarloAgent(int num_stocks, int total_episodes, double epsilon_start = 0.5, double epsilon_end = 0.01, 
+    MonteCarloAgent(int num_stocks, int total_episodes, double epsilon_start = 0.5, double epsilon_end = 0.01,
                     double epsilon_decay = 0.995, double gamma = 0.99, double learning_rate = 0.1)
-        : num_stocks(num_stocks), total_episodes(total_episodes), epsilon_start(epsilon_start), epsilon_end(epsilon_end),
-          epsilon_decay(epsilon_decay), gamma(gamma), learning_rate(learning_rate), current_episode(0),
-          gen(std::random_device{}()), dis(0.0, 1.0) {}
+        : model(FEATURES_PER_STOCK * num_stocks + 1, num_stocks, tileOptions(learning_rate)),
+          gen(std::random_device{}()), dis(0.0, 1.0), epsilon_start(epsilon_start), epsilon_end(epsilon_end),
+          epsilon_decay(epsilon_decay), gamma(gamma), num_stocks(num_stocks), total_episodes(total_episodes),
+          current_episode(0), features(FEATURES_PER_STOCK * num_stocks + 1),
+          candidates(ACTION_CANDIDATES * num_stocks), candidate_values(ACTION_CANDIDATES) {}
+
+    static TileCodingOptions tileOptions(double learning_rate) {
+        TileCodingOptions options;
+        options.learning_rate = learning_rate;
+        return options;
+    }
+
+    // Writes the model inputs for state into out
+    void featurize(const State& state, double* out) const {
+        double value = state.cash;
+        for (int i = 0; i < num_stocks; i++) value += state.holdings[i] * state.prices[i];
+        for (int i = 0; i < num_stocks; i++) {
+            out[FEATURES_PER_STOCK * i] = 0.5 + 10.0 * state.returns[i];  // +-5% spans the range
+            out[FEATURES_PER_STOCK * i + 1] = state.holdings[i] * state.prices[i] / value;
+        }
+        out[FEATURES_PER_STOCK * num_stocks] = state.cash / value;
+    }
 
     std::vector<double> getAction(const State& state) {
         double epsilon = std::max(epsilon_end, epsilon_start * std::pow(epsilon_decay, current_episode));
-        
+
         if (dis(gen) < epsilon) {
             return getRandomAction();
         } else {
-            if (Q.find(state) != Q.end() && !Q[state].empty()) {
-                auto best_action = std::max_element(Q[state].begin(), Q[state].end(),
-                    [](const auto& a, const auto& b) { return a.second < b.second; });
-                return best_action->first;
-            } else {
-                return getRandomAction();
-            }
+            featurize(state, features.data());
+            for (double& a : candidates) a = dis(gen);
+            model.values(features.data(), candidates.data(), ACTION_CANDIDATES, candidate_values.data());
+            int best = static_cast<int>(std::max_element(candidate_values.begin(), candidate_values.end())
+                                        - candidate_values.begin());
+            return std::vector<double>(candidates.begin() + best * num_stocks,
+                                       candidates.begin() + (best + 1) * num_stocks);
         }
     }
 
@@ -60,15 +91,8 @@ public:
         double G = 0.0;
         for (int t = static_cast<int>(states.size()) - 1; t >= 0; t--) {
             G = gamma * G + rewards[t];
-            
-            auto it = std::find_if(Q[states[t]].begin(), Q[states[t]].end(),
-                [&actions, t](const auto& pair) { return pair.first == actions[t]; });
-            
-            if (it == Q[states[t]].end()) {
-                Q[states[t]].push_back({actions[t], G});
-            } else {
-                it->second += learning_rate * (G - it->second);
-            }
+            featurize(states[t], features.data());
+            model.update(features.data(), actions[t].data(), G);
         }
         current_episode++;
     }
@@ -77,6 +101,10 @@ public:
 // In the main function, update the agent initialization:
 MonteCarloAgent agent(num_stocks, num_episodes);
 
+// In TradingEnvironment, add a rolling risk window over the last 20 rewards
+// (cleared in reset()):
+RollingTailRisk reward_risk{0.05, 20};
+
 // In the TradingEnvironment::step function, update the action processing:
 std::pair<State, double> step(const std::vector<double>& actions) {
     double prev_portfolio_value = calculatePortfolioValue();
@@ -108,9 +136,10 @@ std::pair<State, double> step(const std::vector<double>& actions) {
     double new_portfolio_value = calculatePortfolioValue();
     double reward = (new_portfolio_value - prev_portfolio_value) / prev_portfolio_value;
 
-    // Incorporate risk into the reward
-    double var = calculateVaR(0.05, {reward});
-    double cvar = calculateCVaR(0.05, {reward});
+    // Incorporate risk into the reward: VaR and CVaR of the recent rewards,
+    // updated in O(log W) per step
+    reward_risk.push(reward);
+    auto [var, cvar] = reward_risk.current();
     double risk_adjusted_reward = reward - 0.5 * (std::abs(var) + std::abs(cvar));
 
     return {current_state, risk_adjusted_reward};
@@ -0,0 +1,366 @@
+#ifndef __MARKET_DATA_H
+#define __MARKET_DATA_H
+
+// Binary columnar market data.
+//
+// convert_market_data() turns a yfinance CSV (importData/CollectData.py) into
+// a file holding one aligned column per field, and MarketData maps that file
+// read-only. Nothing is parsed or copied at load time: column views point
+// straight into the mapping, and every process that opens the same file
+// shares one copy in the page cache.
+//
+// File layout, all integers little-endian, every section 64-byte aligned:
+//   header       MarketDataHeader
+//   names        n_columns null-terminated column names
+//   dates        n_rows int64 seconds since the Unix epoch (UTC)
+//   columns      n_columns blocks of n_rows doubles, each padded to 64 bytes
+//
+// POSIX only (mmap).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct MarketDataHeader {
+    char magic[8];            // "MKTCOL1\0"
+    std::uint32_t version;
+    std::uint32_t n_columns;  // Numeric columns, excluding the date
+    std::uint64_t n_rows;
+    std::uint64_t names_offset;
+    std::uint64_t dates_offset;
+    std::uint64_t columns_offset;
+    std::uint64_t column_stride;  // Bytes from one column to the next
+    std::uint64_t source_stamp;   // source_stamp() of the CSV it was converted from
+};
+static_assert(sizeof(MarketDataHeader) == 64, "MarketDataHeader must fill one cache line");
+
+const char MARKET_DATA_MAGIC[8] = {'M', 'K', 'T', 'C', 'O', 'L', '1', '\0'};
+const std::uint32_t MARKET_DATA_VERSION = 1;
+const std::size_t MARKET_DATA_ALIGNMENT = 64;
+
+// Read-only view of one column inside the mapping
+template <typename T>
+struct ColumnView {
+    const T* data = nullptr;
+    std::size_t size = 0;
+
+    const T& operator[](std::size_t i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+};
+
+namespace market_data_detail {
+
+inline std::uint64_t align_up(std::uint64_t n) {
+    return (n + MARKET_DATA_ALIGNMENT - 1) / MARKET_DATA_ALIGNMENT * MARKET_DATA_ALIGNMENT;
+}
+
+// True when count items of size bytes starting at offset end by limit;
+// divides instead of multiplying so corrupt headers cannot overflow
+inline bool fits(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::uint64_t limit) {
+    if (offset > limit) return false;
+    return size == 0 || count <= (limit - offset) / size;
+}
+
+// Days from 1970-01-01 to y-m-d in the proleptic Gregorian calendar (Hinnant)
+inline std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+// Parses "YYYY-MM-DD", optionally followed by " HH:MM:SS" and a "+HH:MM" or
+// "-HH:MM" UTC offset, as yfinance writes them. Returns false for anything
+// else, which is how the extra header rows of newer yfinance files are
+// recognised.
+inline bool parse_date(const std::string& text, std::int64_t& seconds) {
+    int y, mo, d, h = 0, mi = 0, s = 0, consumed = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2d%n", &y, &mo, &d, &consumed) != 3) return false;
+    if (mo < 1 || mo > 12 || d < 1 || d > 31) return false;
+    const char* rest = text.c_str() + consumed;
+    if (*rest == ' ' || *rest == 'T') {
+        int more = 0;
+        if (std::sscanf(rest + 1, "%2d:%2d:%2d%n", &h, &mi, &s, &more) != 3) return false;
+        rest += 1 + more;
+    }
+    seconds = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s;
+    if (*rest == '+' || *rest == '-') {
+        int oh, om;
+        if (std::sscanf(rest + 1, "%2d:%2d", &oh, &om) != 2) return false;
+        std::int64_t offset = oh * 3600 + om * 60;
+        seconds += *rest == '+' ? -offset : offset;
+    }
+    return true;
+}
+
+inline std::vector<std::string> split(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string token;
+    while (std::getline(iss, token, ',')) fields.push_back(token);
+    if (!line.empty() && line.back() == ',') fields.emplace_back();
+    for (auto& field : fields) {
+        if (!field.empty() && field.back() == '\r') field.pop_back();
+    }
+    return fields;
+}
+
+// Folds part into a running hash (splitmix64 finalizer)
+inline std::uint64_t mix(std::uint64_t h, std::uint64_t part) {
+    h = (h ^ part) + 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+// Fingerprint of a file's size and modification time, to the nanosecond,
+// so a CSV rewritten within the same second still changes it
+inline std::uint64_t source_stamp(const struct stat& info) {
+#ifdef __APPLE__
+    const struct timespec& mtime = info.st_mtimespec;
+#else
+    const struct timespec& mtime = info.st_mtim;
+#endif
+    std::uint64_t h = mix(static_cast<std::uint64_t>(info.st_size), static_cast<std::uint64_t>(mtime.tv_sec));
+    return mix(h, static_cast<std::uint64_t>(mtime.tv_nsec));
+}
+
+} // namespace market_data_detail
+
+// One-time conversion of a yfinance CSV to the columnar format. The first
+// line names the columns; further rows whose first field is not a date (the
+// ticker lines of newer yfinance files) are skipped, and empty fields become
+// NaN. The output is written to a temporary file and renamed into place, so
+// concurrent readers never see a partial file.
+inline void convert_market_data(const std::string& csv_path, const std::string& output_path) {
+    using namespace market_data_detail;
+
+    // Stamped before reading, so a CSV rewritten mid-conversion is converted again next time
+    struct stat csv_info;
+    if (::stat(csv_path.c_str(), &csv_info) != 0) throw std::runtime_error("Cannot open market data CSV: " + csv_path);
+    std::ifstream file(csv_path);
+    if (!file) throw std::runtime_error("Cannot open market data CSV: " + csv_path);
+
+    std::string line;
+    if (!std::getline(file, line)) throw std::runtime_error("Empty market data CSV: " + csv_path);
+    std::vector<std::string> names = split(line);
+    if (names.size() < 2) throw std::runtime_error("Market data CSV needs a date and at least one column: " + csv_path);
+    names.erase(names.begin());
+    const std::size_t n_columns = names.size();
+
+    std::vector<std::int64_t> dates;
+    std::vector<std::vector<double>> columns(n_columns);
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = split(line);
+        std::int64_t date;
+        if (fields.empty() || !parse_date(fields[0], date)) continue;
+
+        dates.push_back(date);
+        for (std::size_t j = 0; j < n_columns; ++j) {
+            const char* text = j + 1 < fields.size() ? fields[j + 1].c_str() : "";
+            char* end;
+            double value = std::strtod(text, &end);
+            columns[j].push_back(end == text ? NAN : value);
+        }
+    }
+
+    const std::uint64_t n_rows = dates.size();
+    std::string name_block;
+    for (const auto& name : names) {
+        name_block += name;
+        name_block += '\0';
+    }
+
+    MarketDataHeader header{};
+    std::memcpy(header.magic, MARKET_DATA_MAGIC, sizeof(header.magic));
+    header.version = MARKET_DATA_VERSION;
+    header.n_columns = static_cast<std::uint32_t>(n_columns);
+    header.n_rows = n_rows;
+    header.names_offset = sizeof(MarketDataHeader);
+    header.dates_offset = align_up(header.names_offset + name_block.size());
+    header.columns_offset = align_up(header.dates_offset + n_rows * sizeof(std::int64_t));
+    header.column_stride = align_up(n_rows * sizeof(double));
+    header.source_stamp = source_stamp(csv_info);
+
+    std::string temp_path = output_path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Cannot write market data file: " + temp_path);
+
+        std::uint64_t position = 0;
+        auto pad_to = [&](std::uint64_t offset) {
+            static const char zeros[MARKET_DATA_ALIGNMENT] = {};
+            out.write(zeros, static_cast<std::streamsize>(offset - position));
+            position = offset;
+        };
+        auto write = [&](const void* data, std::uint64_t bytes) {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            position += bytes;
+        };
+
+        write(&header, sizeof(header));
+        write(name_block.data(), name_block.size());
+        pad_to(header.dates_offset);
+        write(dates.data(), n_rows * sizeof(std::int64_t));
+        for (std::size_t j = 0; j < n_columns; ++j) {
+            pad_to(header.columns_offset + j * header.column_stride);
+            write(columns[j].data(), n_rows * sizeof(double));
+        }
+        pad_to(header.columns_offset + n_columns * header.column_stride);
+        if (!out) throw std::runtime_error("Failed writing market data file: " + temp_path);
+    }
+    if (std::rename(temp_path.c_str(), output_path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("Cannot move market data file into place: " + output_path);
+    }
+}
+
+// Read-only memory mapping of a converted file
+class MarketData {
+public:
+    MarketData() = default;
+    explicit MarketData(const std::string& path) { open(path); }
+    ~MarketData() { close(); }
+
+    MarketData(const MarketData&) = delete;
+    MarketData& operator=(const MarketData&) = delete;
+    MarketData(MarketData&& other) noexcept { *this = std::move(other); }
+    MarketData& operator=(MarketData&& other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(base_, other.base_);
+            std::swap(length_, other.length_);
+            std::swap(header_, other.header_);
+            names_.swap(other.names_);
+        }
+        return *this;
+    }
+
+    void open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open market data file: " + path);
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(MarketDataHeader))) {
+            ::close(fd);
+            throw std::runtime_error("Truncated market data file: " + path);
+        }
+        length_ = static_cast<std::size_t>(info.st_size);
+        void* base = ::mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) throw std::runtime_error("Cannot map market data file: " + path);
+        base_ = static_cast<const char*>(base);
+        header_ = reinterpret_cast<const MarketDataHeader*>(base_);
+
+        // Every section must lie inside the mapping and before the next one
+        using market_data_detail::fits;
+        const MarketDataHeader& h = *header_;
+        bool valid = std::memcmp(h.magic, MARKET_DATA_MAGIC, sizeof(h.magic)) == 0
+            && h.version == MARKET_DATA_VERSION
+            && h.dates_offset % MARKET_DATA_ALIGNMENT == 0
+            && h.columns_offset % MARKET_DATA_ALIGNMENT == 0
+            && h.column_stride % MARKET_DATA_ALIGNMENT == 0
+            && h.names_offset >= sizeof(MarketDataHeader)
+            && h.names_offset <= h.dates_offset
+            && fits(h.columns_offset, h.n_columns, h.column_stride, length_)
+            && fits(h.dates_offset, h.n_rows, sizeof(std::int64_t), h.columns_offset)
+            && h.column_stride >= h.n_rows * sizeof(double);
+        if (!valid) {
+            close();
+            throw std::runtime_error("Not a market data file: " + path);
+        }
+
+        // Names must be terminated inside their section
+        const char* name = base_ + h.names_offset;
+        const char* names_end = base_ + h.dates_offset;
+        for (std::uint32_t j = 0; j < h.n_columns; ++j) {
+            const void* terminator = std::memchr(name, '\0', static_cast<std::size_t>(names_end - name));
+            if (!terminator) {
+                close();
+                throw std::runtime_error("Corrupt column names in market data file: " + path);
+            }
+            names_.emplace_back(name);
+            name = static_cast<const char*>(terminator) + 1;
+        }
+    }
+
+    void close() {
+        if (base_) ::munmap(const_cast<char*>(base_), length_);
+        base_ = nullptr;
+        header_ = nullptr;
+        length_ = 0;
+        names_.clear();
+    }
+
+    bool is_open() const { return base_ != nullptr; }
+    std::size_t rows() const { return header_ ? header_->n_rows : 0; }
+    std::uint64_t source_stamp() const { return header_ ? header_->source_stamp : 0; }
+    std::size_t columns() const { return names_.size(); }
+    const std::string& column_name(std::size_t j) const { return names_.at(j); }
+
+    ColumnView<std::int64_t> dates() const {
+        return {reinterpret_cast<const std::int64_t*>(base_ + header_->dates_offset), rows()};
+    }
+
+    ColumnView<double> column(std::size_t j) const {
+        if (j >= columns()) throw std::out_of_range("Market data column out of range");
+        return {reinterpret_cast<const double*>(base_ + header_->columns_offset + j * header_->column_stride), rows()};
+    }
+
+    ColumnView<double> column(const std::string& name) const {
+        for (std::size_t j = 0; j < names_.size(); ++j) {
+            if (names_[j] == name) return column(j);
+        }
+        throw std::runtime_error("Market data column not found: " + name);
+    }
+
+private:
+    const char* base_ = nullptr;
+    std::size_t length_ = 0;
+    const MarketDataHeader* header_ = nullptr;
+    std::vector<std::string> names_;
+};
+
+// Opens the columnar cache of a CSV, converting first when the cache is
+// missing, unreadable, or was built from a CSV of another size or
+// modification time. The cache sits next to the CSV as "<csv>.col"; a path
+// that already ends in ".col" is opened directly.
+inline MarketData load_market_data(const std::string& path) {
+    const std::string suffix = ".col";
+    if (path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return MarketData(path);
+    }
+
+    std::string cache_path = path + suffix;
+    struct stat csv_info, cache_info;
+    if (::stat(path.c_str(), &csv_info) != 0) throw std::runtime_error("Cannot open market data CSV: " + path);
+    if (::stat(cache_path.c_str(), &cache_info) == 0) {
+        try {
+            MarketData cached(cache_path);
+            if (cached.source_stamp() == market_data_detail::source_stamp(csv_info)) return cached;
+        } catch (const std::runtime_error&) {
+            // Corrupt or from an older format: rebuild it below
+        }
+    }
+    convert_market_data(path, cache_path);
+    return MarketData(cache_path);
+}
+
+#endif
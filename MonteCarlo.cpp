@@ -1,31 +1,47 @@
 #include <iostream>
 #include <vector>
-#include <map>
+#include <cstdlib>
+#include <new>
 #include <random>
 #include <algorithm>
-#include <fstream>
-#include <sstream>
 #include <cmath>
 #include <numeric>
 #include <iomanip>
-
-enum class Action { Buy, Sell, Hold };
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "BatchTradingEnvironment.hpp"
+#include "MarketData.hpp"
+#include "RiskMetrics.hpp"
+#include "StateIndex.hpp"
+
+#ifdef COUNT_ALLOCATIONS
+// Build with -DCOUNT_ALLOCATIONS to count heap allocations per thread. main
+// then fails if collecting episodes or stepping the environment allocated.
+thread_local std::size_t thread_allocations = 0;
+
+void* operator new(std::size_t size) {
+    thread_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
 
 struct State {
     std::vector<double> prices;
+    std::vector<double> returns;  // Simple return of each column since the previous step
     std::vector<int> holdings;
     double cash;
-
-    bool operator<(const State& other) const {
-        if (cash != other.cash) return cash < other.cash;
-        if (holdings != other.holdings) return holdings < other.holdings;
-        return prices < other.prices;
-    }
 };
 
 class TradingEnvironment {
 private:
-    std::vector<std::vector<double>> historical_data;
+    MarketData market_data;
+    std::vector<ColumnView<double>> columns;
     int current_step;
     double initial_cash;
     State current_state;
@@ -38,42 +54,48 @@ public:
         reset();
     }
 
+    // Maps the columnar cache of the CSV, converting it on first use
     void loadData(const std::string& filename) {
-        std::ifstream file(filename);
-        std::string line;
-        std::getline(file, line); // Skip header
-
-        while (std::getline(file, line)) {
-            std::istringstream iss(line);
-            std::string token;
-            std::vector<double> row;
-
-            std::getline(iss, token, ','); // Skip date
+        market_data = load_market_data(filename);
+        columns.clear();
+        for (std::size_t j = 0; j < market_data.columns(); j++) {
+            columns.push_back(market_data.column(j));
+        }
+        if (market_data.rows() == 0) throw std::runtime_error("No market data rows in " + filename);
+    }
 
-            while (std::getline(iss, token, ',')) {
-                row.push_back(std::stod(token));
-            }
-            historical_data.push_back(row);
+    // Every column of one row, in file order, and its return over the previous row
+    void loadPrices(int step) {
+        current_state.prices.resize(columns.size());
+        current_state.returns.resize(columns.size());
+        for (std::size_t j = 0; j < columns.size(); j++) {
+            current_state.prices[j] = columns[j][step];
+            current_state.returns[j] = step > 0 ? columns[j][step] / columns[j][step - 1] - 1.0 : 0.0;
         }
     }
 
-    State reset() {
+    // The state is updated in place; the reference stays valid for the
+    // lifetime of the environment
+    const State& reset() {
         current_step = 0;
-        current_state.prices = historical_data[current_step];
-        current_state.holdings = std::vector<int>(num_stocks, 0);
+        loadPrices(current_step);
+        current_state.holdings.assign(num_stocks, 0);
         current_state.cash = initial_cash;
         return current_state;
     }
 
-    std::pair<State, double> step(const std::vector<Action>& actions) {
+    const State& state() const { return current_state; }
+
+    // Applies one action per stock and returns the reward
+    double step(const std::vector<Action>& actions) {
         double prev_portfolio_value = calculatePortfolioValue();
         current_step++;
 
-        if (current_step >= historical_data.size()) {
-            return {current_state, 0.0};
+        if (current_step >= static_cast<int>(market_data.rows())) {
+            return 0.0;
         }
 
-        current_state.prices = historical_data[current_step];
+        loadPrices(current_step);
 
         for (int i = 0; i < num_stocks; i++) {
             switch (actions[i]) {
@@ -97,11 +119,11 @@ public:
         double new_portfolio_value = calculatePortfolioValue();
         double reward = (new_portfolio_value - prev_portfolio_value) / prev_portfolio_value;
 
-        return {current_state, reward};
+        return reward;
     }
 
     bool isTerminal() const {
-        return current_step >= historical_data.size() - 1;
+        return current_step >= static_cast<int>(market_data.rows()) - 1;
     }
 
     double calculatePortfolioValue() const {
@@ -111,26 +133,74 @@ public:
         }
         return value;
     }
+};
 
-    double calculateVaR(double alpha, const std::vector<double>& returns) const {
-        std::vector<double> sorted_returns = returns;
-        std::sort(sorted_returns.begin(), sorted_returns.end());
-        int index = static_cast<int>(alpha * sorted_returns.size());
-        return sorted_returns[index];
+// Fixed-capacity structure-of-arrays record of one lockstep batch of
+// episodes, allocated once and overwritten by every batch. Each step keeps,
+// for all `width` portfolios, the market data row, the state the action was
+// chosen in (holdings, cash and its key), the joint action code and the
+// reward. Steps are contiguous: field[t * width + p] is step t of portfolio p.
+class EpisodeBuffer {
+public:
+    EpisodeBuffer(std::size_t max_steps, std::size_t width, int num_stocks)
+        : max_steps_(max_steps), width_(width), num_stocks_(num_stocks),
+          row_(max_steps), cash_(max_steps * width), holdings_(max_steps * width * num_stocks),
+          keys_(max_steps * width), codes_(max_steps * width), rewards_(max_steps * width) {}
+
+    void clear() { steps_ = 0; }
+
+    // Starts step t = steps() from the environment's current state and
+    // returns t; its keys and codes are filled by the agent, its rewards by
+    // finishStep after the environment has stepped
+    std::size_t beginStep(const BatchTradingEnvironment& env) {
+        if (steps_ == max_steps_) throw std::length_error("EpisodeBuffer: episode longer than its capacity");
+        const std::size_t t = steps_++;
+        row_[t] = env.currentStep();
+        std::copy(env.cash(), env.cash() + width_, cash(t));
+        for (int i = 0; i < num_stocks_; i++) {
+            std::copy(env.holdings(i), env.holdings(i) + width_, holdings(t) + i * width_);
+        }
+        return t;
     }
 
-    double calculateCVaR(double alpha, const std::vector<double>& returns) const {
-        double var = calculateVaR(alpha, returns);
-        std::vector<double> tail_losses;
-        std::copy_if(returns.begin(), returns.end(), std::back_inserter(tail_losses),
-                     [var](double r) { return r <= var; });
-        return std::accumulate(tail_losses.begin(), tail_losses.end(), 0.0) / tail_losses.size();
+    void finishStep(std::size_t t, const BatchTradingEnvironment& env) {
+        std::copy(env.rewards(), env.rewards() + width_, rewards(t));
     }
+
+    std::size_t steps() const { return steps_; }
+    std::size_t width() const { return width_; }
+    std::size_t capacity() const { return max_steps_; }
+
+    int row(std::size_t t) const { return row_[t]; }
+    double* cash(std::size_t t) { return &cash_[t * width_]; }
+    std::int32_t* holdings(std::size_t t) { return &holdings_[t * width_ * num_stocks_]; }  // Stock-major within a step
+    std::uint64_t* keys(std::size_t t) { return &keys_[t * width_]; }
+    std::uint64_t* codes(std::size_t t) { return &codes_[t * width_]; }
+    double* rewards(std::size_t t) { return &rewards_[t * width_]; }
+    const std::uint64_t* keys(std::size_t t) const { return &keys_[t * width_]; }
+    const std::uint64_t* codes(std::size_t t) const { return &codes_[t * width_]; }
+    const double* rewards(std::size_t t) const { return &rewards_[t * width_]; }
+
+private:
+    std::size_t max_steps_;
+    std::size_t width_;
+    int num_stocks_;
+    std::size_t steps_ = 0;
+    std::vector<int> row_;
+    std::vector<double> cash_;
+    std::vector<std::int32_t> holdings_;
+    std::vector<std::uint64_t> keys_;
+    std::vector<std::uint64_t> codes_;
+    std::vector<double> rewards_;
 };
 
 class MonteCarloAgent {
 private:
-    std::map<State, std::vector<std::pair<std::vector<Action>, double>>> Q;
+    // Q is keyed by the discretised state, so nearby states share estimates.
+    // Joint actions are coded in base 3, stock 0 in the lowest digit. Q is
+    // sharded so ParallelTrainer workers can read and merge concurrently.
+    StateFeaturizer featurizer;
+    ShardedActionValueTable Q;
     std::mt19937 gen;
     std::uniform_real_distribution<> dis;
 
@@ -138,88 +208,310 @@ private:
     double gamma;
     int num_stocks;
 
+    static std::uint64_t jointActions(int num_stocks) {
+        if (num_stocks > 40) throw std::invalid_argument("Joint action codes support at most 40 stocks");
+        std::uint64_t n = 1;
+        for (int i = 0; i < num_stocks; i++) n *= 3;
+        return n;
+    }
+
 public:
-    MonteCarloAgent(int num_stocks, double epsilon = 0.1, double gamma = 0.99)
-        : num_stocks(num_stocks), epsilon(epsilon), gamma(gamma), gen(std::random_device{}()), dis(0.0, 1.0) {}
+    MonteCarloAgent(int num_stocks, double initial_cash, double epsilon = 0.1, double gamma = 0.99)
+        : featurizer(num_stocks, initial_cash), Q(jointActions(num_stocks)), gen(std::random_device{}()), dis(0.0, 1.0),
+          epsilon(epsilon), gamma(gamma), num_stocks(num_stocks) {}
 
-    std::vector<Action> getAction(const State& state) {
-        if (dis(gen) < epsilon) {
-            return getRandomAction();
+    std::uint64_t stateKey(const State& state) const {
+        return featurizer.key(state.returns, state.holdings, state.cash);
+    }
+
+    std::uint64_t encodeAction(const std::vector<Action>& actions) const {
+        std::uint64_t code = 0;
+        for (int i = num_stocks - 1; i >= 0; i--) {
+            code = code * 3 + static_cast<std::uint64_t>(actions[i]);
+        }
+        return code;
+    }
+
+    void decodeAction(std::uint64_t code, std::vector<Action>& actions) const {
+        actions.resize(num_stocks);
+        for (int i = 0; i < num_stocks; i++) {
+            actions[i] = static_cast<Action>(code % 3);
+            code /= 3;
+        }
+    }
+
+    void setEpsilon(double value) { epsilon = value; }
+
+    // Epsilon-greedy joint action code for a state key. Safe to call from
+    // several threads as long as each passes its own generator.
+    std::uint64_t chooseAction(std::uint64_t key, std::mt19937& rng) const {
+        std::uniform_real_distribution<> u(0.0, 1.0);
+        if (u(rng) < epsilon) {
+            return randomAction(rng);
         } else {
-            if (Q.find(state) != Q.end() && !Q[state].empty()) {
-                auto best_action = std::max_element(Q[state].begin(), Q[state].end(),
-                    [](const auto& a, const auto& b) { return a.second < b.second; });
-                return best_action->first;
+            std::uint64_t best_action = 0;
+            if (Q.best(key, best_action)) {
+                return best_action;
             } else {
-                return getRandomAction();
+                return randomAction(rng);
             }
         }
     }
 
-    std::vector<Action> getRandomAction() {
-        std::vector<Action> actions(num_stocks);
+    std::uint64_t randomAction(std::mt19937& rng) const {
+        std::uniform_real_distribution<> u(0.0, 1.0);
+        std::uint64_t code = 0;
         for (int i = 0; i < num_stocks; i++) {
-            actions[i] = static_cast<Action>(dis(gen) * 3);
+            code = code * 3 + static_cast<std::uint64_t>(u(rng) * 3);
         }
-        return actions;
+        return code;
     }
 
-    void update(const std::vector<State>& states, const std::vector<std::vector<Action>>& actions, const std::vector<double>& rewards) {
-        double G = 0.0;
-        for (int t = static_cast<int>(states.size()) - 1; t >= 0; t--) {
-            G = gamma * G + rewards[t];
-            
-            auto it = std::find_if(Q[states[t]].begin(), Q[states[t]].end(),
-                [&actions, t](const auto& pair) { return pair.first == actions[t]; });
-            
-            if (it == Q[states[t]].end()) {
-                Q[states[t]].push_back({actions[t], G});
-            } else {
-                it->second += (G - it->second) / (std::count_if(Q[states[t]].begin(), Q[states[t]].end(),
-                    [&actions, t](const auto& pair) { return pair.first == actions[t]; }) + 1);
+    void getAction(const State& state, std::vector<Action>& actions) {
+        decodeAction(chooseAction(stateKey(state), gen), actions);
+    }
+
+    // One action per portfolio of a lockstep batch. keys and codes receive
+    // the state key and joint action code of each portfolio, for update;
+    // actions receives the stock-major layout BatchTradingEnvironment::step takes.
+    void getActions(const BatchTradingEnvironment& env, std::uint64_t* keys, std::uint64_t* codes, Action* actions,
+                    std::mt19937& rng) const {
+        const std::size_t n = env.size();
+        for (std::size_t p = 0; p < n; p++) {
+            keys[p] = featurizer.key(env.returns(), env.holdings(0) + p, n, env.cash()[p]);
+            codes[p] = chooseAction(keys[p], rng);
+            std::uint64_t code = codes[p];
+            for (int i = 0; i < num_stocks; i++) {
+                actions[i * n + p] = static_cast<Action>(code % 3);
+                code /= 3;
+            }
+        }
+    }
+
+    // Every-visit Monte Carlo over a batch of episodes: each (state, action)
+    // value is the mean of the returns that followed it. The returns of every
+    // step are written to updates, grouped by Q shard by a counting sort:
+    // shard s gets updates[shard_offsets[s], shard_offsets[s + 1]), in
+    // portfolio order and backwards in time within each portfolio. updates
+    // needs room for steps * width entries, shard_offsets for shards() + 1.
+    void collectUpdates(const EpisodeBuffer& episodes, ActionUpdate* updates, std::size_t* shard_offsets) const {
+        const std::size_t steps = episodes.steps(), width = episodes.width();
+        std::fill(shard_offsets, shard_offsets + Q.shards() + 1, 0);
+        for (std::size_t t = 0; t < steps; t++) {
+            const std::uint64_t* keys = episodes.keys(t);
+            for (std::size_t p = 0; p < width; p++) shard_offsets[Q.shardOf(keys[p]) + 1]++;
+        }
+        for (std::size_t s = 0; s < Q.shards(); s++) shard_offsets[s + 1] += shard_offsets[s];
+
+        // shard_offsets[s] is used as the insertion cursor of shard s, which
+        // leaves it at the start of shard s + 1; shifted back below
+        for (std::size_t p = 0; p < width; p++) {
+            double G = 0.0;
+            for (std::size_t t = steps; t-- > 0;) {
+                G = gamma * G + episodes.rewards(t)[p];
+                std::uint64_t key = episodes.keys(t)[p];
+                updates[shard_offsets[Q.shardOf(key)]++] = {key, episodes.codes(t)[p], G};
             }
         }
+        for (std::size_t s = Q.shards(); s > 0; s--) shard_offsets[s] = shard_offsets[s - 1];
+        shard_offsets[0] = 0;
     }
+
+    void merge(const ActionUpdate* updates, const std::size_t* shard_offsets) { Q.apply(updates, shard_offsets); }
+
+    std::size_t shards() const { return Q.shards(); }
+
+    std::size_t states() const { return Q.states(); }
 };
 
-int main() {
-    const std::string data_file = "AAPL_1y_1d.csv";
-    const double initial_cash = 100000.0;
-    const int num_episodes = 10000;
-    const int num_stocks = 1;
+struct TrainerOptions {
+    unsigned n_threads = 0;        // 0 uses every hardware thread
+    std::size_t batch_size = 100;  // Episodes per lockstep batch
+    std::uint64_t seed = 0;
+    // Run in rounds: every worker collects one batch against the same Q,
+    // then the batches are merged in order. The same seed and n_threads then
+    // always give the same Q. Otherwise workers merge as soon as they finish.
+    bool deterministic = false;
+};
 
-    TradingEnvironment env(data_file, initial_cash, num_stocks);
-    MonteCarloAgent agent(num_stocks);
+// Portfolio 0 of one batch, for progress reports
+struct BatchReport {
+    std::size_t first_episode;
+    double final_value;
+    std::vector<double> rewards;
+};
 
-    for (int episode = 0; episode < num_episodes; episode++) {
-        State state = env.reset();
-        std::vector<State> states;
-        std::vector<std::vector<Action>> actions;
-        std::vector<double> rewards;
+// Collects episodes on several threads. Each worker owns a
+// BatchTradingEnvironment over the shared MarketData, its episode buffers and
+// a generator seeded from (seed, batch index); returns are merged into the
+// agent's sharded Q one shard lock at a time.
+class ParallelTrainer {
+private:
+    struct Worker {
+        Worker(const MarketData& data, std::size_t batch_size, int num_stocks, double initial_cash)
+            : env(data, batch_size, num_stocks, initial_cash),
+              episodes(static_cast<std::size_t>(env.rows()), batch_size, num_stocks),
+              actions(num_stocks * batch_size), updates(episodes.capacity() * batch_size) {
+            report.rewards.reserve(episodes.capacity());
+        }
 
-        while (!env.isTerminal()) {
-            std::vector<Action> action = agent.getAction(state);
-            auto [next_state, reward] = env.step(action);
+        BatchTradingEnvironment env;
+        std::mt19937 gen;
+        // Everything collect() touches is sized here, once
+        EpisodeBuffer episodes;
+        std::vector<Action> actions;
+        std::vector<ActionUpdate> updates;
+        std::vector<std::size_t> shard_offsets;
+        BatchReport report;
+#ifdef COUNT_ALLOCATIONS
+        std::size_t step_allocations = 0;
+#endif
+    };
+
+    MonteCarloAgent& agent;
+    TrainerOptions options;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    void collect(Worker& w, std::size_t batch) {
+        const std::size_t n = options.batch_size;
+        std::seed_seq seq{static_cast<std::uint32_t>(options.seed), static_cast<std::uint32_t>(options.seed >> 32),
+                          static_cast<std::uint32_t>(batch), static_cast<std::uint32_t>(batch >> 32)};
+        w.gen.seed(seq);
+
+#ifdef COUNT_ALLOCATIONS
+        const std::size_t allocations_before = thread_allocations;
+#endif
+        w.env.reset();
+        w.episodes.clear();
+        while (!w.env.isTerminal()) {
+            std::size_t t = w.episodes.beginStep(w.env);
+            agent.getActions(w.env, w.episodes.keys(t), w.episodes.codes(t), w.actions.data(), w.gen);
+            w.env.step(w.actions.data());
+            w.episodes.finishStep(t, w.env);
+        }
 
-            states.push_back(state);
-            actions.push_back(action);
-            rewards.push_back(reward);
+        agent.collectUpdates(w.episodes, w.updates.data(), w.shard_offsets.data());
 
-            state = next_state;
+        const std::size_t steps = w.episodes.steps();
+        w.report.first_episode = batch * n;
+        w.report.final_value = w.env.values()[0];
+        w.report.rewards.resize(steps);
+        for (std::size_t t = 0; t < steps; t++) w.report.rewards[t] = w.episodes.rewards(t)[0];
+#ifdef COUNT_ALLOCATIONS
+        w.step_allocations += thread_allocations - allocations_before;
+#endif
+    }
+
+public:
+    ParallelTrainer(const MarketData& data, MonteCarloAgent& agent, int num_stocks, double initial_cash,
+                    const TrainerOptions& options)
+        : agent(agent), options(options) {
+        if (this->options.batch_size == 0) throw std::invalid_argument("ParallelTrainer: batch_size must be positive");
+        if (this->options.n_threads == 0) this->options.n_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 0; t < this->options.n_threads; t++) {
+            workers.emplace_back(new Worker(data, this->options.batch_size, num_stocks, initial_cash));
+            workers.back()->shard_offsets.resize(agent.shards() + 1);
         }
+    }
 
-        agent.update(states, actions, rewards);
+    // Runs num_episodes, rounded up to whole batches. report is called once
+    // per batch, never concurrently; in deterministic mode in batch order.
+    void train(std::size_t num_episodes, const std::function<void(const BatchReport&)>& report) {
+        const std::size_t n_batches = (num_episodes + options.batch_size - 1) / options.batch_size;
+        const std::size_t n_workers = std::min<std::size_t>(workers.size(), n_batches);
+        if (n_workers == 0) return;
+
+        if (options.deterministic) {
+            for (std::size_t round = 0; round < n_batches; round += n_workers) {
+                const std::size_t count = std::min(n_workers, n_batches - round);
+                std::vector<std::thread> threads;
+                for (std::size_t w = 1; w < count; w++) {
+                    threads.emplace_back(&ParallelTrainer::collect, this, std::ref(*workers[w]), round + w);
+                }
+                collect(*workers[0], round);
+                for (auto& thread : threads) thread.join();
+                for (std::size_t w = 0; w < count; w++) {
+                    agent.merge(workers[w]->updates.data(), workers[w]->shard_offsets.data());
+                    report(workers[w]->report);
+                }
+            }
+            return;
+        }
+
+        std::atomic<std::size_t> next_batch(0);
+        std::mutex report_mutex;
+        auto run = [&](Worker& w) {
+            for (std::size_t batch; (batch = next_batch++) < n_batches;) {
+                collect(w, batch);
+                agent.merge(w.updates.data(), w.shard_offsets.data());
+                std::lock_guard<std::mutex> lock(report_mutex);
+                report(w.report);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t w = 1; w < n_workers; w++) threads.emplace_back(run, std::ref(*workers[w]));
+        run(*workers[0]);
+        for (auto& thread : threads) thread.join();
+    }
 
-        if (episode % 100 == 0) {
-            double final_value = env.calculatePortfolioValue();
-            double var = env.calculateVaR(0.05, rewards);
-            double cvar = env.calculateCVaR(0.05, rewards);
-            std::cout << "Episode " << episode << " completed. Final portfolio value: " << std::fixed << std::setprecision(2) << final_value
+#ifdef COUNT_ALLOCATIONS
+    // Heap allocations made while collecting episodes, over all workers
+    std::size_t stepAllocations() const {
+        std::size_t total = 0;
+        for (const auto& w : workers) total += w->step_allocations;
+        return total;
+    }
+#endif
+};
+
+int main() {
+    const std::string data_file = "AAPL_1y_1d.csv";
+    const double initial_cash = 100000.0;
+    const int num_episodes = 10000;
+    const int num_stocks = 1;
+
+    TrainerOptions options;
+    options.batch_size = 100;
+    options.seed = std::random_device{}();
+    options.deterministic = false;
+
+    MarketData market_data = load_market_data(data_file);
+    TradingEnvironment env(data_file, initial_cash, num_stocks);
+    MonteCarloAgent agent(num_stocks, initial_cash);
+    ParallelTrainer trainer(market_data, agent, num_stocks, initial_cash, options);
+
+    std::vector<double> scratch;
+    trainer.train(num_episodes, [&](const BatchReport& batch) {
+        if (batch.first_episode % 100 == 0) {
+            auto [var, cvar] = tail_risk(0.05, batch.rewards, scratch);
+            std::cout << "Episode " << batch.first_episode << " completed. Final portfolio value: " << std::fixed << std::setprecision(2) << batch.final_value
                       << ", VaR(5%): " << std::setprecision(4) << var << ", CVaR(5%): " << cvar << std::endl;
         }
+    });
+
+    std::cout << "Training completed. States visited: " << agent.states() << std::endl;
+
+    // One greedy episode through the single-portfolio environment
+    agent.setEpsilon(0.0);
+    std::vector<double> episode_rewards;
+    episode_rewards.reserve(market_data.rows());
+    std::vector<Action> action(num_stocks);
+    env.reset();
+#ifdef COUNT_ALLOCATIONS
+    const std::size_t allocations_before = thread_allocations;
+#endif
+    while (!env.isTerminal()) {
+        agent.getAction(env.state(), action);
+        episode_rewards.push_back(env.step(action));
     }
-
-    std::cout << "Training completed." << std::endl;
+#ifdef COUNT_ALLOCATIONS
+    const std::size_t step_allocations = trainer.stepAllocations() + thread_allocations - allocations_before;
+    std::cout << "Heap allocations on the step path: " << step_allocations << std::endl;
+    if (step_allocations != 0) return 1;
+#endif
+    auto [var, cvar] = tail_risk(0.05, episode_rewards.data(), episode_rewards.size());
+    std::cout << "Greedy policy: final portfolio value: " << std::setprecision(2) << env.calculatePortfolioValue()
+              << ", VaR(5%): " << std::setprecision(4) << var << ", CVaR(5%): " << cvar << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,90 @@
+// Accuracy and throughput of the normal CDF kernels against std::erfc.
+//
+// Build:
+//   clang++ -std=c++17 -O3 -march=native -fno-math-errno -fno-trapping-math NormalBenchmark.cpp NormalDistribution.cpp -o NormalBenchmark
+#include "NormalDistribution.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <algorithm>
+
+// Best wall time of `repeats` runs, in seconds
+template <typename F>
+double time_best(F f, int repeats = 5) {
+    double best = 1e300;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+struct ErrorStats {
+    double max_abs = 0.0;
+    double max_rel_central = 0.0;  // |x| <= 5
+    double max_rel_tail = 0.0;     // |x| > 5, where the reference is a normal double
+};
+
+// Errors against a long double reference on a fine grid over [-38, 9]
+template <typename F>
+ErrorStats measure(F cdf) {
+    ErrorStats stats;
+    for (long i = -380000; i <= 90000; ++i) {
+        double x = i * 1e-4;
+        long double reference = 0.5L * std::erfc(-static_cast<long double>(x) / std::sqrt(2.0L));
+        double value = cdf(x);
+        double abs_error = static_cast<double>(std::fabs(value - reference));
+        stats.max_abs = std::max(stats.max_abs, abs_error);
+        if (reference < 1e-300L) continue;
+        double rel_error = static_cast<double>(abs_error / reference);
+        if (std::fabs(x) <= 5.0) stats.max_rel_central = std::max(stats.max_rel_central, rel_error);
+        else stats.max_rel_tail = std::max(stats.max_rel_tail, rel_error);
+    }
+    return stats;
+}
+
+void report(const std::string& label, double seconds, std::size_t n, const ErrorStats& e) {
+    std::cout << std::left << std::setw(18) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << n / seconds / 1e6 << " M/s" << std::scientific << std::setprecision(2)
+              << std::setw(12) << e.max_abs << std::setw(12) << e.max_rel_central
+              << std::setw(12) << e.max_rel_tail << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t n = argc > 1 ? std::stoul(argv[1]) : 4000000;
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<> dist(-10.0, 10.0);
+    std::vector<double> x(n), out(n);
+    std::vector<float> xf(n), outf(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = dist(gen);
+        xf[i] = static_cast<float>(x[i]);
+    }
+
+    double t_erfc = time_best([&]() {
+        for (std::size_t i = 0; i < n; ++i) out[i] = 0.5 * std::erfc(-x[i] * M_SQRT1_2);
+    });
+    double t_full = time_best([&]() { norm_cdf(x.data(), out.data(), n, NormalAccuracy::Full); });
+    double t_high = time_best([&]() { norm_cdf(x.data(), out.data(), n, NormalAccuracy::High); });
+    double t_fast = time_best([&]() { norm_cdf(x.data(), out.data(), n, NormalAccuracy::Fast); });
+    double t_float = time_best([&]() { norm_cdf(xf.data(), outf.data(), n); });
+
+    std::cout << "Normal CDF over " << n << " points in [-10, 10]; errors on [-38, 9]\n"
+              << std::left << std::setw(18) << "kernel" << std::right << std::setw(13) << "throughput"
+              << std::setw(12) << "max abs" << std::setw(12) << "rel |x|<=5" << std::setw(12) << "rel tail" << "\n";
+    report("std::erfc", t_erfc, n, measure([](double v) { return 0.5 * std::erfc(-v * M_SQRT1_2); }));
+    report("Full", t_full, n, measure([](double v) { return norm_cdf<NormalAccuracy::Full>(v); }));
+    report("High", t_high, n, measure([](double v) { return norm_cdf<NormalAccuracy::High>(v); }));
+    report("Fast", t_fast, n, measure([](double v) { return norm_cdf<NormalAccuracy::Fast>(v); }));
+    report("Fast (float)", t_float, n,
+        measure([](double v) { return static_cast<double>(norm_cdf(static_cast<float>(v))); }));
+
+    return 0;
+}
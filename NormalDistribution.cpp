@@ -0,0 +1,39 @@
+#include "NormalDistribution.hpp"
+
+namespace {
+
+template <NormalAccuracy Accuracy>
+void cdf_loop(const double* x, double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = norm_cdf<Accuracy>(x[i]);
+}
+
+template <NormalAccuracy Accuracy>
+void pdf_loop(const double* x, double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = norm_pdf<Accuracy>(x[i]);
+}
+
+} // namespace
+
+void norm_cdf(const double* x, double* out, std::size_t n, NormalAccuracy accuracy) {
+    switch (accuracy) {
+        case NormalAccuracy::Full: cdf_loop<NormalAccuracy::Full>(x, out, n); break;
+        case NormalAccuracy::High: cdf_loop<NormalAccuracy::High>(x, out, n); break;
+        case NormalAccuracy::Fast: cdf_loop<NormalAccuracy::Fast>(x, out, n); break;
+    }
+}
+
+void norm_pdf(const double* x, double* out, std::size_t n, NormalAccuracy accuracy) {
+    switch (accuracy) {
+        case NormalAccuracy::Full: pdf_loop<NormalAccuracy::Full>(x, out, n); break;
+        case NormalAccuracy::High: pdf_loop<NormalAccuracy::High>(x, out, n); break;
+        case NormalAccuracy::Fast: pdf_loop<NormalAccuracy::Fast>(x, out, n); break;
+    }
+}
+
+void norm_cdf(const float* x, float* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = norm_cdf(x[i]);
+}
+
+void norm_pdf(const float* x, float* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = norm_pdf(x[i]);
+}
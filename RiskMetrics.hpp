@@ -0,0 +1,188 @@
+#ifndef __RISK_METRICS_H
+#define __RISK_METRICS_H
+
+// Historical value at risk and conditional value at risk of a return series.
+//
+// VaR at level alpha is the order statistic at index floor(alpha * n) of the
+// returns, and CVaR is the mean of every return at or below it. Both are
+// reported as returns, so losses are negative.
+//
+// tail_risk() finds them by selection (std::nth_element), O(n) on average,
+// instead of a full sort. RollingTailRisk keeps them for the last W returns
+// of a stream in O(log W) per new return.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+struct TailRisk {
+    double var;
+    double cvar;
+};
+
+namespace risk_detail {
+
+inline std::size_t var_index(double alpha, std::size_t n) {
+    std::size_t k = static_cast<std::size_t>(alpha * n);
+    return k < n ? k : n - 1;
+}
+
+// Running sum with Neumaier compensation, so adding a large value and later
+// removing it gives back the sum of the small ones to rounding
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void add(double x) {
+        double t = sum + x;
+        compensation += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+        sum = t;
+    }
+
+    double value() const { return sum + compensation; }
+};
+
+} // namespace risk_detail
+
+// VaR and CVaR of returns[0, n). Reorders the returns in place; NaN for n = 0.
+inline TailRisk tail_risk(double alpha, double* returns, std::size_t n) {
+    if (n == 0) {
+        double NaN = std::numeric_limits<double>::quiet_NaN();
+        return {NaN, NaN};
+    }
+    std::size_t k = risk_detail::var_index(alpha, n);
+    std::nth_element(returns, returns + k, returns + n);
+    double var = returns[k];
+
+    // Everything before k is at or below var; ties may also sit after it
+    double sum = 0.0;
+    for (std::size_t i = 0; i <= k; ++i) sum += returns[i];
+    std::size_t count = k + 1;
+    for (std::size_t i = k + 1; i < n; ++i) {
+        if (returns[i] <= var) {
+            sum += returns[i];
+            count++;
+        }
+    }
+    return {var, sum / count};
+}
+
+// As above, leaving the returns untouched: they are copied into scratch,
+// which only allocates when it has to grow
+inline TailRisk tail_risk(double alpha, const double* returns, std::size_t n, std::vector<double>& scratch) {
+    scratch.assign(returns, returns + n);
+    return tail_risk(alpha, scratch.data(), n);
+}
+
+inline TailRisk tail_risk(double alpha, const std::vector<double>& returns, std::vector<double>& scratch) {
+    return tail_risk(alpha, returns.data(), returns.size(), scratch);
+}
+
+// VaR and CVaR over a sliding window of the last `window` returns. The
+// window is split into two ordered multisets: `lower` holds the
+// floor(alpha * size) + 1 smallest returns, so VaR is its largest element
+// and CVaR follows from its compensated running sum, and `upper` holds the
+// rest.
+// push() and cvar() are O(log W), var() is O(1). Non-finite returns, such
+// as the NaN of a missing market data field, are skipped: they have no
+// place in the ordering, so the window holds the last W finite returns.
+class RollingTailRisk {
+public:
+    RollingTailRisk(double alpha, std::size_t window) : alpha_(alpha), window_(window) {
+        if (window == 0) throw std::invalid_argument("RollingTailRisk needs a positive window");
+        if (!(alpha >= 0.0 && alpha < 1.0)) throw std::invalid_argument("RollingTailRisk needs alpha in [0, 1)");
+        ring_.reserve(window);
+    }
+
+    void push(double r) {
+        if (!std::isfinite(r)) return;
+        if (ring_.size() == window_) {
+            double oldest = ring_[head_];
+            ring_[head_] = r;
+            head_ = head_ + 1 == window_ ? 0 : head_ + 1;
+            erase(oldest);
+        } else {
+            ring_.push_back(r);
+        }
+        insert(r);
+        rebalance();
+    }
+
+    std::size_t size() const { return lower_.size() + upper_.size(); }
+
+    double var() const {
+        return lower_.empty() ? std::numeric_limits<double>::quiet_NaN() : *lower_.rbegin();
+    }
+
+    double cvar() const {
+        if (lower_.empty()) return std::numeric_limits<double>::quiet_NaN();
+        double var = *lower_.rbegin();
+        std::size_t ties = upper_.count(var);
+        return (lower_sum_.value() + ties * var) / (lower_.size() + ties);
+    }
+
+    TailRisk current() const { return {var(), cvar()}; }
+
+    void clear() {
+        ring_.clear();
+        head_ = 0;
+        lower_.clear();
+        upper_.clear();
+        lower_sum_ = risk_detail::CompensatedSum();
+    }
+
+private:
+    void insert(double r) {
+        if (!lower_.empty() && r <= *lower_.rbegin()) {
+            lower_.insert(r);
+            lower_sum_.add(r);
+        } else {
+            upper_.insert(r);
+        }
+    }
+
+    void erase(double r) {
+        auto it = upper_.find(r);
+        if (it != upper_.end()) {
+            upper_.erase(it);
+            return;
+        }
+        it = lower_.find(r);
+        if (it != lower_.end()) {
+            lower_.erase(it);
+            lower_sum_.add(-r);
+        }
+    }
+
+    // Restores lower_.size() == floor(alpha * size) + 1
+    void rebalance() {
+        std::size_t target = risk_detail::var_index(alpha_, size()) + 1;
+        while (lower_.size() > target) {
+            auto it = std::prev(lower_.end());
+            lower_sum_.add(-*it);
+            upper_.insert(*it);
+            lower_.erase(it);
+        }
+        while (lower_.size() < target) {
+            auto it = upper_.begin();
+            lower_sum_.add(*it);
+            lower_.insert(*it);
+            upper_.erase(it);
+        }
+    }
+
+    double alpha_;
+    std::size_t window_;
+    std::vector<double> ring_;  // Last `window_` returns; ring_[head_] is the oldest once full
+    std::size_t head_ = 0;
+    std::multiset<double> lower_;
+    std::multiset<double> upper_;
+    risk_detail::CompensatedSum lower_sum_;
+};
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef __STATE_INDEX_H
+#define __STATE_INDEX_H
+
+// Discretised trading states and an open-addressing table keyed by them.
+//
+// StateFeaturizer packs a state (per-stock price returns, holdings and cash)
+// into a 64-bit key: each stock contributes a return bin and a position
+// bucket, and the cash level fills the bits above. FlatStateMap stores its
+// values inline next to the keys in one flat array with linear probing, so
+// a lookup is a hash and usually a single cache line. ActionValueTable keeps
+// the running mean return and visit count of every (state, joint action)
+// pair on top of it, with joint actions given as integer codes, and
+// ShardedActionValueTable splits that table over lock-striped shards so
+// several training threads can share it.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct StateFeatures {
+    double return_bin_width = 0.005;  // Width of one return bin (0.5%)
+    int return_bins = 15;             // Centred on zero; the outer bins take the tails
+    int position_buckets = 8;         // 0, 1, 2-3, 4-7, ...; the last bucket takes the rest
+    int cash_buckets = 32;            // Cash / initial cash over [0, 2)
+};
+
+class StateFeaturizer {
+public:
+    StateFeaturizer(int num_stocks, double initial_cash, const StateFeatures& features = StateFeatures())
+        : num_stocks_(num_stocks), initial_cash_(initial_cash), features_(features) {
+        if (features.return_bins < 1 || features.position_buckets < 1 || features.cash_buckets < 1)
+            throw std::invalid_argument("StateFeatures needs at least one bin of each kind");
+        if (!(features.return_bin_width > 0.0) || !(initial_cash > 0.0))
+            throw std::invalid_argument("StateFeaturizer needs a positive bin width and initial cash");
+
+        return_bits_ = bits_for(features.return_bins);
+        position_bits_ = bits_for(features.position_buckets);
+        int total = num_stocks * (return_bits_ + position_bits_) + bits_for(features.cash_buckets);
+        // The top bit stays clear so no key collides with FlatStateMap's empty marker
+        if (total > 63)
+            throw std::invalid_argument("State key needs " + std::to_string(total) + " bits; at most 63 fit");
+    }
+
+    std::uint64_t key(const std::vector<double>& returns, const std::vector<int>& holdings, double cash) const {
+        return key(returns.data(), holdings.data(), 1, cash);
+    }
+
+    // Holdings of stock i at holdings[i * holdings_stride], as in the
+    // stock-major layout of BatchTradingEnvironment
+    std::uint64_t key(const double* returns, const int* holdings, std::size_t holdings_stride, double cash) const {
+        std::uint64_t key = 0;
+        for (int i = 0; i < num_stocks_; i++) {
+            key = (key << return_bits_) | returnBin(returns[i]);
+            key = (key << position_bits_) | positionBucket(holdings[i * holdings_stride]);
+        }
+        int cash_bucket = clamp(static_cast<int>(std::floor(cash / initial_cash_ * 0.5 * features_.cash_buckets)),
+                                features_.cash_buckets);
+        return (static_cast<std::uint64_t>(cash_bucket) << (num_stocks_ * (return_bits_ + position_bits_))) | key;
+    }
+
+    const StateFeatures& features() const { return features_; }
+
+private:
+    static int bits_for(int n) {
+        int bits = 0;
+        while ((1 << bits) < n) bits++;
+        return bits;
+    }
+
+    static int clamp(int bin, int n) { return bin < 0 ? 0 : bin >= n ? n - 1 : bin; }
+
+    std::uint64_t returnBin(double r) const {
+        // NaN (a missing price) falls in the centre bin
+        double offset = r / features_.return_bin_width + 0.5 * features_.return_bins;
+        return static_cast<std::uint64_t>(clamp(offset == offset ? static_cast<int>(std::floor(offset)) : features_.return_bins / 2,
+                                                features_.return_bins));
+    }
+
+    std::uint64_t positionBucket(int holdings) const {
+        int bucket = 0;
+        while (holdings > 0) {
+            bucket++;
+            holdings >>= 1;
+        }
+        return static_cast<std::uint64_t>(clamp(bucket, features_.position_buckets));
+    }
+
+    int num_stocks_;
+    double initial_cash_;
+    StateFeatures features_;
+    int return_bits_;
+    int position_bits_;
+};
+
+// splitmix64 finaliser: state keys are dense bit fields, so mix before masking
+inline std::uint64_t state_hash(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Open-addressing hash map from state keys to V, with V stored inline.
+// Capacity is a power of two and doubles past 70% load. References and
+// pointers into the map are invalidated by any insertion.
+template <typename V>
+class FlatStateMap {
+public:
+    static const std::uint64_t EMPTY = ~std::uint64_t(0);
+
+    explicit FlatStateMap(std::size_t initial_capacity = 1024) {
+        std::size_t capacity = 16;
+        while (capacity < initial_capacity) capacity <<= 1;
+        slots_.resize(capacity);
+    }
+
+    V* find(std::uint64_t key) {
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+            if (slots_[i].key == key) return &slots_[i].value;
+            if (slots_[i].key == EMPTY) return nullptr;
+        }
+    }
+
+    const V* find(std::uint64_t key) const { return const_cast<FlatStateMap*>(this)->find(key); }
+
+    // Value for key, default-constructed on first use
+    V& operator[](std::uint64_t key) {
+        if ((size_ + 1) * 10 > slots_.size() * 7) grow();
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+            if (slots_[i].key == key) return slots_[i].value;
+            if (slots_[i].key == EMPTY) {
+                slots_[i].key = key;
+                size_++;
+                return slots_[i].value;
+            }
+        }
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return slots_.size(); }
+
+    template <typename F>
+    void for_each(F f) const {
+        for (const auto& slot : slots_) {
+            if (slot.key != EMPTY) f(slot.key, slot.value);
+        }
+    }
+
+private:
+    struct Slot {
+        std::uint64_t key = EMPTY;
+        V value{};
+    };
+
+    static std::size_t hash(std::uint64_t key) { return static_cast<std::size_t>(state_hash(key)); }
+
+    void grow() {
+        std::vector<Slot> old(slots_.size() * 2);
+        old.swap(slots_);
+        std::size_t mask = slots_.size() - 1;
+        for (auto& slot : old) {
+            if (slot.key == EMPTY) continue;
+            std::size_t i = hash(slot.key) & mask;
+            while (slots_[i].key != EMPTY) i = (i + 1) & mask;
+            slots_[i].key = slot.key;
+            slots_[i].value = std::move(slot.value);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+};
+
+// Mean return and visit count of one (state, action) pair
+struct ActionStats {
+    double value = 0.0;
+    std::uint64_t visits = 0;
+};
+
+// Action values per state for actions coded 0 .. num_actions - 1. Up to
+// dense_limit actions, each state owns a contiguous row of num_actions
+// ActionStats in one shared pool; above it, each state has its own small
+// FlatStateMap of the actions actually taken. Either way an update is O(1).
+class ActionValueTable {
+public:
+    explicit ActionValueTable(std::uint64_t num_actions, std::uint64_t dense_limit = 729)
+        : num_actions_(num_actions), dense_(num_actions <= dense_limit) {
+        if (num_actions == 0) throw std::invalid_argument("ActionValueTable needs at least one action");
+    }
+
+    // Folds the return G into the running mean of (state, action)
+    void update(std::uint64_t state, std::uint64_t action, double G) {
+        std::size_t before = rows_.size();
+        std::size_t& row = rows_[state];
+        if (rows_.size() != before) {
+            row = dense_ ? pool_.size() / num_actions_ : sparse_rows_.size();
+            if (dense_) pool_.resize(pool_.size() + num_actions_);
+            else sparse_rows_.emplace_back(16);
+        }
+        ActionStats& stats = dense_ ? pool_[row * num_actions_ + action] : sparse_rows_[row][action];
+        stats.visits++;
+        stats.value += (G - stats.value) / stats.visits;
+    }
+
+    // Visited action with the highest mean return; false if the state has none
+    bool best(std::uint64_t state, std::uint64_t& action) const {
+        const std::size_t* row = rows_.find(state);
+        if (!row) return false;
+        bool found = false;
+        double best_value = 0.0;
+        auto consider = [&](std::uint64_t a, const ActionStats& stats) {
+            if (stats.visits > 0 && (!found || stats.value > best_value)) {
+                found = true;
+                best_value = stats.value;
+                action = a;
+            }
+        };
+        if (dense_) {
+            const ActionStats* stats = &pool_[*row * num_actions_];
+            for (std::uint64_t a = 0; a < num_actions_; a++) consider(a, stats[a]);
+        } else {
+            sparse_rows_[*row].for_each(consider);
+        }
+        return found;
+    }
+
+    ActionStats stats(std::uint64_t state, std::uint64_t action) const {
+        const std::size_t* row = rows_.find(state);
+        if (!row) return ActionStats();
+        if (dense_) return pool_[*row * num_actions_ + action];
+        const ActionStats* stats = sparse_rows_[*row].find(action);
+        return stats ? *stats : ActionStats();
+    }
+
+    std::size_t states() const { return rows_.size(); }
+    std::uint64_t actions() const { return num_actions_; }
+
+private:
+    std::uint64_t num_actions_;
+    bool dense_;
+    FlatStateMap<std::size_t> rows_;                         // State key -> row
+    std::vector<ActionStats> pool_;                          // Dense rows, num_actions_ each
+    std::vector<FlatStateMap<ActionStats>> sparse_rows_;     // Sparse rows
+};
+
+// One return to fold into the table
+struct ActionUpdate {
+    std::uint64_t state;
+    std::uint64_t action;
+    double G;
+};
+
+// ActionValueTable split into a power-of-two number of shards, each behind
+// its own reader-writer lock. A state always lives in the same shard, picked
+// by the top bits of its hash (FlatStateMap uses the low bits), so readers
+// and writers of different states rarely contend. Writers hand over their
+// updates pre-grouped by shard and take each lock once per batch.
+class ShardedActionValueTable {
+public:
+    explicit ShardedActionValueTable(std::uint64_t num_actions, std::size_t shards = 64, std::uint64_t dense_limit = 729)
+        : num_actions_(num_actions) {
+        if (shards == 0 || (shards & (shards - 1)) != 0)
+            throw std::invalid_argument("ShardedActionValueTable needs a power-of-two shard count");
+        while ((std::size_t(1) << shard_bits_) < shards) shard_bits_++;
+        for (std::size_t s = 0; s < shards; s++) shards_.emplace_back(new Shard(num_actions, dense_limit));
+    }
+
+    std::size_t shards() const { return shards_.size(); }
+
+    std::size_t shardOf(std::uint64_t state) const {
+        return shard_bits_ == 0 ? 0 : static_cast<std::size_t>(state_hash(state) >> (64 - shard_bits_));
+    }
+
+    void update(std::uint64_t state, std::uint64_t action, double G) {
+        Shard& shard = *shards_[shardOf(state)];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.table.update(state, action, G);
+    }
+
+    // Applies updates[shard_offsets[s], shard_offsets[s + 1]) to shard s, in
+    // order, for every s < shards(). Updates of one (state, action) pair are
+    // applied in the order given, so merging the same batches in the same
+    // order gives the same table.
+    void apply(const ActionUpdate* updates, const std::size_t* shard_offsets) {
+        for (std::size_t s = 0; s < shards_.size(); s++) {
+            if (shard_offsets[s] == shard_offsets[s + 1]) continue;
+            std::unique_lock<std::shared_mutex> lock(shards_[s]->mutex);
+            for (std::size_t i = shard_offsets[s]; i < shard_offsets[s + 1]; i++) {
+                shards_[s]->table.update(updates[i].state, updates[i].action, updates[i].G);
+            }
+        }
+    }
+
+    bool best(std::uint64_t state, std::uint64_t& action) const {
+        const Shard& shard = *shards_[shardOf(state)];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.table.best(state, action);
+    }
+
+    ActionStats stats(std::uint64_t state, std::uint64_t action) const {
+        const Shard& shard = *shards_[shardOf(state)];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.table.stats(state, action);
+    }
+
+    std::size_t states() const {
+        std::size_t total = 0;
+        for (const auto& shard : shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            total += shard->table.states();
+        }
+        return total;
+    }
+
+    std::uint64_t actions() const { return num_actions_; }
+
+private:
+    struct alignas(64) Shard {
+        Shard(std::uint64_t num_actions, std::uint64_t dense_limit) : table(num_actions, dense_limit) {}
+        mutable std::shared_mutex mutex;
+        ActionValueTable table;
+    };
+
+    std::uint64_t num_actions_;
+    int shard_bits_ = 0;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif
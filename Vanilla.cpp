@@ -1,10 +1,11 @@
 #include "Vanilla.hpp"
+#include "NormalDistribution.hpp"
 #include <cmath>
 #include <algorithm> // for std::max
 
 // Standard normal cumulative distribution function (CDF)
 double N(double x) {
-    return 0.5 * erfc(-x * M_SQRT1_2); // N(x) using error function approximation
+    return norm_cdf(x); // Full-accuracy kernel, see NormalDistribution.hpp
 }
 
 void Vanilla::init() {
@@ -36,7 +37,7 @@ Vanilla::Vanilla(const Vanilla& rhs) {
 }
 
 // Parameterized constructor
-Vanilla::Vanilla(double _K, double _r, double _T, double _S, double _sigma) {
+Vanilla::Vanilla(double _K, double _T, double _r, double _S, double _sigma) {
     K = _K;
     r = _r;
     T = _T;
@@ -80,3 +81,30 @@ double Vanilla::calc_put_price() const {
     
     return K * exp(-r * T) * N(-d2) - S * N(-d1);
 }
+
+// Prices and Greeks from a single evaluation of d1, d2 and the normal tails
+VanillaGreeks Vanilla::calc_greeks() const {
+    double sqrt_T = sqrt(T);
+    double sigma_sqrt_T = sigma * sqrt_T;
+    double d1 = (log(S / K) + (r + 0.5 * sigma * sigma) * T) / sigma_sqrt_T;
+    double d2 = d1 - sigma_sqrt_T;
+
+    double disc_K = K * exp(-r * T);
+    double N1 = N(d1), N2 = N(d2);
+    double N1_neg = N(-d1), N2_neg = N(-d2);  // Not 1 - N(d): keeps precision deep in the tails
+    double pdf1 = norm_pdf(d1);
+    double decay = -S * pdf1 * sigma / (2.0 * sqrt_T);
+
+    VanillaGreeks g;
+    g.call_price = S * N1 - disc_K * N2;
+    g.put_price = disc_K * N2_neg - S * N1_neg;
+    g.call_delta = N1;
+    g.put_delta = -N1_neg;
+    g.gamma = pdf1 / (S * sigma_sqrt_T);
+    g.vega = S * pdf1 * sqrt_T;
+    g.call_theta = decay - r * disc_K * N2;
+    g.put_theta = decay + r * disc_K * N2_neg;
+    g.call_rho = T * disc_K * N2;
+    g.put_rho = -T * disc_K * N2_neg;
+    return g;
+}
@@ -1,6 +1,22 @@
 #ifndef __VANILLA_OPTION_H
 #define __VANILLA_OPTION_H
 
+// Black-Scholes prices and analytic sensitivities for both sides of one
+// option. Theta is per year of calendar time, vega and rho per unit (not
+// percentage point) of volatility and rate.
+struct VanillaGreeks {
+    double call_price;
+    double put_price;
+    double call_delta;
+    double put_delta;
+    double gamma;        // Same for call and put
+    double vega;         // Same for call and put
+    double call_theta;
+    double put_theta;
+    double call_rho;
+    double put_rho;
+};
+
 class Vanilla {
 private:
     // Private member variables
@@ -32,6 +48,9 @@ public:
     // Option pricing methods
     double calc_call_price() const;  // Calculate European Call price
     double calc_put_price() const;   // Calculate European Put price
+
+    // Prices and Greeks in one pass, sharing d1, d2, N(d1), N(d2) and the PDF
+    VanillaGreeks calc_greeks() const;
 };
 
 // Standard normal cumulative distribution function (to be implemented)
@@ -0,0 +1,145 @@
+#include "VanillaBatch.hpp"
+#include "NormalDistribution.hpp"
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Options per inner block. Intermediates for a block stay in L1, and each
+// loop below is a straight-line body the compiler can vectorize.
+const std::size_t BLOCK = 256;
+
+// Books smaller than this are priced on the calling thread
+const std::size_t PARALLEL_THRESHOLD = 16384;
+
+void evaluate_range(const VanillaBatch& book, const VanillaGreeksBatch& out,
+                    std::size_t begin, std::size_t end) {
+    double d1[BLOCK], d2[BLOCK], sqrt_T[BLOCK], disc_K[BLOCK];
+    double tail1[BLOCK], tail2[BLOCK], pdf1[BLOCK];
+
+    const bool need_pdf = out.gamma || out.vega || out.call_theta || out.put_theta;
+
+    for (std::size_t base = begin; base < end; base += BLOCK) {
+        const std::size_t n = std::min(BLOCK, end - base);
+        const double* K = book.K + base;
+        const double* T = book.T + base;
+        const double* r = book.r + base;
+        const double* S = book.S + base;
+        const double* sigma = book.sigma + base;
+
+        // Shared inputs: d1, d2 and the discounted strike
+        for (std::size_t i = 0; i < n; ++i) {
+            sqrt_T[i] = std::sqrt(T[i]);
+            double sigma_sqrt_T = sigma[i] * sqrt_T[i];
+            d1[i] = (std::log(S[i] / K[i]) + (r[i] + 0.5 * sigma[i] * sigma[i]) * T[i]) / sigma_sqrt_T;
+            d2[i] = d1[i] - sigma_sqrt_T;
+            disc_K[i] = K[i] * std::exp(-r[i] * T[i]);
+        }
+
+        // One CDF evaluation per d: the upper tail of |d| serves N(d) and
+        // N(-d) without losing precision for deep in/out-of-the-money options
+        for (std::size_t i = 0; i < n; ++i) {
+            tail1[i] = norm_cdf(-std::fabs(d1[i]));
+            tail2[i] = norm_cdf(-std::fabs(d2[i]));
+        }
+        if (need_pdf) {
+            for (std::size_t i = 0; i < n; ++i) pdf1[i] = norm_pdf(d1[i]);
+        }
+
+        // N(d) and N(-d) overwrite the tails in place: tail1/tail2 become
+        // N(d1)/N(d2), and d1/d2 become N(-d1)/N(-d2)
+        double* N1 = tail1;
+        double* N2 = tail2;
+        double* N1_neg = d1;
+        double* N2_neg = d2;
+        for (std::size_t i = 0; i < n; ++i) {
+            double t1 = tail1[i], t2 = tail2[i];
+            bool pos1 = d1[i] > 0.0, pos2 = d2[i] > 0.0;
+            N1[i] = pos1 ? 1.0 - t1 : t1;
+            N1_neg[i] = pos1 ? t1 : 1.0 - t1;
+            N2[i] = pos2 ? 1.0 - t2 : t2;
+            N2_neg[i] = pos2 ? t2 : 1.0 - t2;
+        }
+
+        if (out.call_price) {
+            for (std::size_t i = 0; i < n; ++i) out.call_price[base + i] = S[i] * N1[i] - disc_K[i] * N2[i];
+        }
+        if (out.put_price) {
+            for (std::size_t i = 0; i < n; ++i) out.put_price[base + i] = disc_K[i] * N2_neg[i] - S[i] * N1_neg[i];
+        }
+        if (out.call_delta) {
+            for (std::size_t i = 0; i < n; ++i) out.call_delta[base + i] = N1[i];
+        }
+        if (out.put_delta) {
+            for (std::size_t i = 0; i < n; ++i) out.put_delta[base + i] = -N1_neg[i];
+        }
+        if (out.gamma) {
+            for (std::size_t i = 0; i < n; ++i) out.gamma[base + i] = pdf1[i] / (S[i] * sigma[i] * sqrt_T[i]);
+        }
+        if (out.vega) {
+            for (std::size_t i = 0; i < n; ++i) out.vega[base + i] = S[i] * pdf1[i] * sqrt_T[i];
+        }
+        if (out.call_theta) {
+            for (std::size_t i = 0; i < n; ++i) {
+                double decay = -S[i] * pdf1[i] * sigma[i] / (2.0 * sqrt_T[i]);
+                out.call_theta[base + i] = decay - r[i] * disc_K[i] * N2[i];
+            }
+        }
+        if (out.put_theta) {
+            for (std::size_t i = 0; i < n; ++i) {
+                double decay = -S[i] * pdf1[i] * sigma[i] / (2.0 * sqrt_T[i]);
+                out.put_theta[base + i] = decay + r[i] * disc_K[i] * N2_neg[i];
+            }
+        }
+        if (out.call_rho) {
+            for (std::size_t i = 0; i < n; ++i) out.call_rho[base + i] = T[i] * disc_K[i] * N2[i];
+        }
+        if (out.put_rho) {
+            for (std::size_t i = 0; i < n; ++i) out.put_rho[base + i] = -T[i] * disc_K[i] * N2_neg[i];
+        }
+    }
+}
+
+} // namespace
+
+void batch_greeks(const VanillaBatch& book, const VanillaGreeksBatch& out, unsigned n_threads) {
+    if (book.size == 0) return;
+
+    if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (book.size < PARALLEL_THRESHOLD) n_threads = 1;
+
+    // Contiguous, block-aligned slices; the calling thread takes the first
+    std::size_t n_blocks = (book.size + BLOCK - 1) / BLOCK;
+    n_threads = static_cast<unsigned>(std::min<std::size_t>(n_threads, n_blocks));
+    auto slice_begin = [&](unsigned t) {
+        return std::min(book.size, n_blocks * t / n_threads * BLOCK);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+    for (unsigned t = 1; t < n_threads; ++t) {
+        workers.emplace_back(evaluate_range, std::cref(book), std::cref(out), slice_begin(t), slice_begin(t + 1));
+    }
+    evaluate_range(book, out, 0, slice_begin(1));
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void batch_price(const VanillaBatch& book, double* calls, double* puts, unsigned n_threads) {
+    if (!calls && !puts) return;
+    VanillaGreeksBatch out;
+    out.call_price = calls;
+    out.put_price = puts;
+    batch_greeks(book, out, n_threads);
+}
+
+void batch_call_price(const VanillaBatch& book, double* calls, unsigned n_threads) {
+    batch_price(book, calls, nullptr, n_threads);
+}
+
+void batch_put_price(const VanillaBatch& book, double* puts, unsigned n_threads) {
+    batch_price(book, nullptr, puts, n_threads);
+}
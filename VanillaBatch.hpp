@@ -0,0 +1,45 @@
+#ifndef __VANILLA_BATCH_H
+#define __VANILLA_BATCH_H
+
+#include <cstddef>
+
+// Structure-of-arrays view of an option book. Every array holds `size`
+// entries; entry i describes the same option as
+// Vanilla(K[i], T[i], r[i], S[i], sigma[i]).
+struct VanillaBatch {
+    const double* K;      // Strike prices
+    const double* T;      // Times to expiration (years)
+    const double* r;      // Risk-free interest rates
+    const double* S;      // Underlying asset prices
+    const double* sigma;  // Volatilities
+    std::size_t size;
+};
+
+// Price a whole book with Black-Scholes in one pass. d1, d2 and the discount
+// factor are computed once per option and shared by both sides. Either output
+// may be null to skip that side. n_threads = 0 uses every hardware thread.
+void batch_price(const VanillaBatch& book, double* calls, double* puts, unsigned n_threads = 0);
+
+void batch_call_price(const VanillaBatch& book, double* calls, unsigned n_threads = 0);
+void batch_put_price(const VanillaBatch& book, double* puts, unsigned n_threads = 0);
+
+// Output columns for batch_greeks, each `book.size` long. Any column may be
+// null to skip it. Conventions match VanillaGreeks.
+struct VanillaGreeksBatch {
+    double* call_price = nullptr;
+    double* put_price = nullptr;
+    double* call_delta = nullptr;
+    double* put_delta = nullptr;
+    double* gamma = nullptr;
+    double* vega = nullptr;
+    double* call_theta = nullptr;
+    double* put_theta = nullptr;
+    double* call_rho = nullptr;
+    double* put_rho = nullptr;
+};
+
+// Prices and analytic Greeks for a whole book. d1, d2, the normal tails and
+// the PDF are evaluated once per option and shared by every output.
+void batch_greeks(const VanillaBatch& book, const VanillaGreeksBatch& out, unsigned n_threads = 0);
+
+#endif
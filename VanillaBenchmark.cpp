@@ -0,0 +1,153 @@
+// Throughput of the scalar Vanilla pricer against the batched SoA pricer.
+//
+// Build:
+//   clang++ -std=c++17 -O3 -march=native -fno-math-errno -fno-trapping-math VanillaBenchmark.cpp VanillaBatch.cpp Vanilla.cpp NormalDistribution.cpp -o VanillaBenchmark
+#include "Vanilla.hpp"
+#include "VanillaBatch.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+// Best wall time of `repeats` runs, in seconds
+template <typename F>
+double time_best(F f, int repeats = 5) {
+    double best = 1e300;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    // Random book around the money
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> strike(50.0, 150.0), expiry(0.05, 3.0), rate(0.0, 0.08),
+        spot(80.0, 120.0), vol(0.05, 0.8);
+    std::vector<double> K(n), T(n), r(n), S(n), sigma(n);
+    std::vector<Vanilla> options;
+    options.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        K[i] = strike(gen);
+        T[i] = expiry(gen);
+        r[i] = rate(gen);
+        S[i] = spot(gen);
+        sigma[i] = vol(gen);
+        options.emplace_back(K[i], T[i], r[i], S[i], sigma[i]);
+    }
+    VanillaBatch book{K.data(), T.data(), r.data(), S.data(), sigma.data(), n};
+
+    std::vector<double> scalar_calls(n), scalar_puts(n), calls(n), puts(n);
+
+    double scalar = time_best([&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            scalar_calls[i] = options[i].calc_call_price();
+            scalar_puts[i] = options[i].calc_put_price();
+        }
+    });
+    double single = time_best([&]() { batch_price(book, calls.data(), puts.data(), 1); });
+    double threaded = time_best([&]() { batch_price(book, calls.data(), puts.data()); });
+
+    double max_error = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        max_error = std::max(max_error, std::fabs(calls[i] - scalar_calls[i]));
+        max_error = std::max(max_error, std::fabs(puts[i] - scalar_puts[i]));
+    }
+
+    auto rate_of = [n](double seconds) { return n / seconds / 1e6; };
+    std::cout << "Options priced (call + put): " << n << "\n" << std::fixed << std::setprecision(2)
+              << "  Scalar Vanilla:        " << rate_of(scalar) << " M options/s\n"
+              << "  Batch, 1 thread:       " << rate_of(single) << " M options/s ("
+              << scalar / single << "x)\n"
+              << "  Batch, all threads:    " << rate_of(threaded) << " M options/s ("
+              << scalar / threaded << "x)\n"
+              << std::scientific << std::setprecision(3)
+              << "  Max |batch - scalar|:  " << max_error << "\n";
+
+    // Greeks: central bump-and-reprice (two repricings per Greek) against
+    // the analytic single-pass paths
+    std::vector<VanillaGreeks> scalar_greeks(n);
+    std::vector<double> call_delta(n), put_delta(n), gamma(n), vega(n), call_theta(n), put_theta(n),
+        call_rho(n), put_rho(n);
+    VanillaGreeksBatch out;
+    out.call_price = calls.data();
+    out.put_price = puts.data();
+    out.call_delta = call_delta.data();
+    out.put_delta = put_delta.data();
+    out.gamma = gamma.data();
+    out.vega = vega.data();
+    out.call_theta = call_theta.data();
+    out.put_theta = put_theta.data();
+    out.call_rho = call_rho.data();
+    out.put_rho = put_rho.data();
+
+    double bumped = time_best([&]() {
+        for (std::size_t i = 0; i < n; ++i) {
+            const Vanilla& o = options[i];
+            double hS = 1e-4 * o.getS(), hv = 1e-4, hT = 1e-5, hr = 1e-5;
+            Vanilla up_S(o.getK(), o.getT(), o.getr(), o.getS() + hS, o.getSigma());
+            Vanilla down_S(o.getK(), o.getT(), o.getr(), o.getS() - hS, o.getSigma());
+            Vanilla up_v(o.getK(), o.getT(), o.getr(), o.getS(), o.getSigma() + hv);
+            Vanilla down_v(o.getK(), o.getT(), o.getr(), o.getS(), o.getSigma() - hv);
+            Vanilla up_T(o.getK(), o.getT() + hT, o.getr(), o.getS(), o.getSigma());
+            Vanilla down_T(o.getK(), o.getT() - hT, o.getr(), o.getS(), o.getSigma());
+            Vanilla up_r(o.getK(), o.getT(), o.getr() + hr, o.getS(), o.getSigma());
+            Vanilla down_r(o.getK(), o.getT(), o.getr() - hr, o.getS(), o.getSigma());
+            VanillaGreeks& g = scalar_greeks[i];
+            double c = o.calc_call_price(), c_up = up_S.calc_call_price(), c_down = down_S.calc_call_price();
+            g.call_delta = (c_up - c_down) / (2 * hS);
+            g.gamma = (c_up - 2 * c + c_down) / (hS * hS);
+            g.put_delta = (up_S.calc_put_price() - down_S.calc_put_price()) / (2 * hS);
+            g.vega = (up_v.calc_call_price() - down_v.calc_call_price()) / (2 * hv);
+            g.call_theta = -(up_T.calc_call_price() - down_T.calc_call_price()) / (2 * hT);
+            g.put_theta = -(up_T.calc_put_price() - down_T.calc_put_price()) / (2 * hT);
+            g.call_rho = (up_r.calc_call_price() - down_r.calc_call_price()) / (2 * hr);
+            g.put_rho = (up_r.calc_put_price() - down_r.calc_put_price()) / (2 * hr);
+        }
+    }, 1);
+    double analytic = time_best([&]() {
+        for (std::size_t i = 0; i < n; ++i) scalar_greeks[i] = options[i].calc_greeks();
+    });
+    double greeks_single = time_best([&]() { batch_greeks(book, out, 1); });
+    double greeks_threaded = time_best([&]() { batch_greeks(book, out); });
+
+    // Relative to the size of each Greek across the book
+    auto max_rel_diff = [n](const std::vector<double>& batch, auto field, const std::vector<VanillaGreeks>& g) {
+        double diff = 0.0, scale = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            diff = std::max(diff, std::fabs(batch[i] - g[i].*field));
+            scale = std::max(scale, std::fabs(g[i].*field));
+        }
+        return scale > 0.0 ? diff / scale : diff;
+    };
+    double greeks_error = 0.0;
+    greeks_error = std::max(greeks_error, max_rel_diff(call_delta, &VanillaGreeks::call_delta, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(put_delta, &VanillaGreeks::put_delta, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(gamma, &VanillaGreeks::gamma, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(vega, &VanillaGreeks::vega, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(call_theta, &VanillaGreeks::call_theta, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(put_theta, &VanillaGreeks::put_theta, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(call_rho, &VanillaGreeks::call_rho, scalar_greeks));
+    greeks_error = std::max(greeks_error, max_rel_diff(put_rho, &VanillaGreeks::put_rho, scalar_greeks));
+
+    std::cout << "\nGreeks (prices + 8 sensitivities): " << n << "\n" << std::fixed << std::setprecision(2)
+              << "  Bump and reprice:      " << rate_of(bumped) << " M options/s\n"
+              << "  Vanilla::calc_greeks:  " << rate_of(analytic) << " M options/s ("
+              << bumped / analytic << "x)\n"
+              << "  Batch, 1 thread:       " << rate_of(greeks_single) << " M options/s ("
+              << bumped / greeks_single << "x)\n"
+              << "  Batch, all threads:    " << rate_of(greeks_threaded) << " M options/s ("
+              << bumped / greeks_threaded << "x)\n"
+              << std::scientific << std::setprecision(3)
+              << "  Max rel |batch - scalar|: " << greeks_error << "\n";
+
+    return 0;
+}
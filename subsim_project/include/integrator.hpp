@@ -0,0 +1,244 @@
+#pragma once
+#include "philox.hpp"
+#include "qmc.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Plain Monte Carlo integration over an interval.
+//
+// Sample i is the uniform drawn from Philox block i / 2 of the seed's stream
+// 0, so the sample set depends only on the seed and the sample count. Threads
+// take contiguous, block-aligned ranges of sample indices and seek straight
+// to them. Each thread draws a block of samples, evaluates the integrand on
+// the whole block and folds the block's mean and squared deviations into its
+// partial result; partials are merged at the end.
+//
+// The Sampler overload takes its points from a (usually quasi-random) point
+// set instead. QMC points are not independent, so the spread of single
+// samples says nothing about the error; the points are split into
+// `replicates` independently randomized copies of the set and the standard
+// error is that of the replicate means.
+
+struct IntegrationResult {
+    double estimate;
+    double standard_error;
+    std::uint64_t samples;
+};
+
+struct IntegratorOptions {
+    int n_threads = 0;  // 0 = hardware concurrency
+    std::uint64_t seed = 0x5EED;
+    int replicates = 16;  // Randomizations of a Sampler; see the Sampler overload
+};
+
+namespace integrator_detail {
+
+// Samples per inner block
+const std::size_t BLOCK = 256;
+
+// Runs shorter than this stay on the calling thread
+const std::uint64_t PARALLEL_THRESHOLD = 1 << 16;
+
+// Count, mean and sum of squared deviations, merged pairwise (Chan et al.)
+struct Partial {
+    std::uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void merge(std::uint64_t n, double block_mean, double block_m2) {
+        if (n == 0) return;
+        std::uint64_t total = count + n;
+        double delta = block_mean - mean;
+        mean += delta * static_cast<double>(n) / static_cast<double>(total);
+        m2 += block_m2 + delta * delta * static_cast<double>(count) * static_cast<double>(n) / static_cast<double>(total);
+        count = total;
+    }
+};
+
+// The integrand may take one point, double f(double), or a batch,
+// void f(const double* x, double* y, std::size_t n). A batch integrand can
+// run its own SIMD loop; a scalar one is called in a plain loop over the
+// block, which the compiler vectorizes when f is simple enough.
+template<typename F>
+inline void evaluate(F& f, const double* x, double* y, std::size_t n) {
+    if constexpr (std::is_invocable_v<F&, const double*, double*, std::size_t>) {
+        f(x, y, n);
+    } else {
+        for (std::size_t i = 0; i < n; ++i) y[i] = f(x[i]);
+    }
+}
+
+template<typename F>
+Partial integrate_range(F& f, double lower, double upper, std::uint64_t seed,
+                        std::uint64_t begin, std::uint64_t end) {
+    double x[BLOCK], y[BLOCK];
+    Partial partial;
+    PhiloxStream stream(seed, 0, begin / 2);
+
+    for (std::uint64_t base = begin; base < end; base += BLOCK) {
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(BLOCK, end - base));
+        stream.fill_uniform(x, n, lower, upper);
+        evaluate(f, x, y, n);
+
+        double sum = 0.0;
+        for (std::size_t i = 0; i < n; ++i) sum += y[i];
+        double mean = sum / static_cast<double>(n);
+        double m2 = 0.0;
+        for (std::size_t i = 0; i < n; ++i) m2 += (y[i] - mean) * (y[i] - mean);
+        partial.merge(n, mean, m2);
+    }
+    return partial;
+}
+
+// Sum of f over points [begin, end) of the sampler, coordinate 0 mapped to
+// [lower, upper)
+template<typename F>
+double sum_sampler_range(F& f, double lower, double upper, const Sampler& sampler,
+                         std::uint64_t begin, std::uint64_t end) {
+    const std::size_t dims = static_cast<std::size_t>(sampler.dimensions());
+    std::vector<double> points(BLOCK * dims);
+    double x[BLOCK], y[BLOCK];
+    const double width = upper - lower;
+    double sum = 0.0;
+
+    for (std::uint64_t base = begin; base < end; base += BLOCK) {
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(BLOCK, end - base));
+        sampler.fill(base, n, points.data());
+        for (std::size_t i = 0; i < n; ++i) x[i] = lower + width * points[i * dims];
+        evaluate(f, x, y, n);
+        for (std::size_t i = 0; i < n; ++i) sum += y[i];
+    }
+    return sum;
+}
+
+} // namespace integrator_detail
+
+// Estimate of the integral of f over [lower, upper] from `samples` uniform
+// points, with its standard error. The result does not depend on n_threads
+// beyond floating-point summation order.
+template<typename F>
+IntegrationResult integrate(F f, double lower, double upper, std::uint64_t samples,
+                            const IntegratorOptions& options = IntegratorOptions()) {
+    using namespace integrator_detail;
+    if (samples == 0) throw std::invalid_argument("samples must be positive");
+    if (options.n_threads < 0) throw std::invalid_argument("n_threads must not be negative");
+
+    std::uint64_t n_threads = options.n_threads > 0
+        ? static_cast<std::uint64_t>(options.n_threads)
+        : std::max(1u, std::thread::hardware_concurrency());
+    if (samples < PARALLEL_THRESHOLD) n_threads = 1;
+
+    // Contiguous, block-aligned slices; the calling thread takes the first
+    const std::uint64_t n_blocks = (samples + BLOCK - 1) / BLOCK;
+    n_threads = std::min(n_threads, n_blocks);
+    auto slice_begin = [&](std::uint64_t t) { return std::min(samples, n_blocks * t / n_threads * BLOCK); };
+
+    std::vector<Partial> partials(n_threads);
+    std::vector<std::exception_ptr> errors(n_threads);
+    auto run = [&](std::uint64_t t) {
+        try {
+            F local = f;
+            partials[t] = integrate_range(local, lower, upper, options.seed, slice_begin(t), slice_begin(t + 1));
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::uint64_t t = 1; t < n_threads; ++t) workers.emplace_back(run, t);
+    run(0);
+    for (auto& worker : workers) worker.join();
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    Partial total;
+    for (const Partial& p : partials) total.merge(p.count, p.mean, p.m2);
+
+    const double width = upper - lower;
+    const double n = static_cast<double>(total.count);
+    const double variance = total.count > 1 ? total.m2 / (n - 1.0) : 0.0;
+    return {width * total.mean, std::fabs(width) * std::sqrt(variance / n), total.count};
+}
+
+// Randomized quasi-Monte Carlo estimate of the integral of f over
+// [lower, upper]: `samples` points split evenly over options.replicates
+// copies of the sampler, each reseeded from options.seed, using coordinate 0
+// of each point. Sobol' points converge best when samples / replicates is a
+// power of two. Unrandomized samplers (SobolSampler without scrambling, an
+// unscrambled HaltonSampler) give identical replicates and a standard error
+// of 0, which is not an error bound.
+template<typename F>
+IntegrationResult integrate(F f, double lower, double upper, std::uint64_t samples,
+                            const Sampler& sampler, const IntegratorOptions& options = IntegratorOptions()) {
+    using namespace integrator_detail;
+    if (options.n_threads < 0) throw std::invalid_argument("n_threads must not be negative");
+    if (options.replicates < 2) throw std::invalid_argument("replicates must be at least 2");
+    const std::uint64_t replicates = static_cast<std::uint64_t>(options.replicates);
+    const std::uint64_t per_replicate = samples / replicates;
+    if (per_replicate == 0) throw std::invalid_argument("samples must be at least replicates");
+
+    std::vector<std::unique_ptr<Sampler>> randomized;
+    for (std::uint64_t r = 0; r < replicates; ++r) {
+        randomized.push_back(sampler.reseeded(qmc_detail::mix(options.seed + r)));
+    }
+
+    std::uint64_t n_threads = options.n_threads > 0
+        ? static_cast<std::uint64_t>(options.n_threads)
+        : std::max(1u, std::thread::hardware_concurrency());
+    if (per_replicate * replicates < PARALLEL_THRESHOLD) n_threads = 1;
+
+    // Work items are (replicate, block) pairs in replicate-major order; each
+    // thread takes a contiguous run of them and sums per replicate
+    const std::uint64_t blocks_per_replicate = (per_replicate + BLOCK - 1) / BLOCK;
+    const std::uint64_t n_items = blocks_per_replicate * replicates;
+    n_threads = std::min(n_threads, n_items);
+    auto slice_begin = [&](std::uint64_t t) { return n_items * t / n_threads; };
+
+    std::vector<std::vector<double>> sums(n_threads, std::vector<double>(replicates, 0.0));
+    std::vector<std::exception_ptr> errors(n_threads);
+    auto run = [&](std::uint64_t t) {
+        try {
+            F local = f;
+            const std::uint64_t end = slice_begin(t + 1);
+            for (std::uint64_t item = slice_begin(t); item < end;) {
+                const std::uint64_t r = item / blocks_per_replicate;
+                const std::uint64_t last = std::min(end, (r + 1) * blocks_per_replicate);
+                const std::uint64_t first_point = (item - r * blocks_per_replicate) * BLOCK;
+                const std::uint64_t end_point = std::min(per_replicate, (last - r * blocks_per_replicate) * BLOCK);
+                sums[t][r] += sum_sampler_range(local, lower, upper, *randomized[r], first_point, end_point);
+                item = last;
+            }
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::uint64_t t = 1; t < n_threads; ++t) workers.emplace_back(run, t);
+    run(0);
+    for (auto& worker : workers) worker.join();
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    Partial total;
+    for (std::uint64_t r = 0; r < replicates; ++r) {
+        double sum = 0.0;
+        for (std::uint64_t t = 0; t < n_threads; ++t) sum += sums[t][r];
+        total.merge(1, sum / static_cast<double>(per_replicate), 0.0);
+    }
+
+    const double width = upper - lower;
+    const double n = static_cast<double>(replicates);
+    const double variance = total.m2 / (n - 1.0);
+    return {width * total.mean, std::fabs(width) * std::sqrt(variance / n), per_replicate * replicates};
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include "subsim.hpp"
+#include "thread_pool.hpp"
+#include "streaming_stats.hpp"
+#include "qmc.hpp"
+#include "path_block.hpp"
 #include <vector>
 #include <functional>
 #include <memory>
@@ -8,6 +12,7 @@
 #include <optional>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 
 // Statistical results container
 struct StatisticalResult {
@@ -18,25 +23,192 @@ struct StatisticalResult {
         : values(v), overall_value(o) {}
 };
 
+// Reductions computed by get_variable_statistics
+enum StatisticMask : unsigned {
+    STAT_MEAN = 1u << 0,
+    STAT_MEDIAN = 1u << 1,
+    STAT_VARIANCE = 1u << 2,
+    STAT_STDDEV = 1u << 3,
+    STAT_MIN = 1u << 4,
+    STAT_MAX = 1u << 5,
+    STAT_SUM = 1u << 6,
+    STAT_ALL = (1u << 7) - 1
+};
+
+// Several statistics of one variable; only the requested ones are filled
+struct VariableStatistics {
+    StatisticalResult mean;
+    StatisticalResult median;
+    StatisticalResult variance;
+    StatisticalResult stddev;
+    StatisticalResult min;
+    StatisticalResult max;
+    StatisticalResult sum;
+};
+
+// Mean of a variable at one step with the run's variance reduction applied
+struct MonteCarloEstimate {
+    double mean = 0.0;
+    double standard_error = 0.0;
+    std::uint64_t paths = 0;
+    // Plain independent paths that would give the same standard error; its
+    // ratio to `paths` is the gain of the variance reduction
+    double effective_paths = 0.0;
+    // Kish effective sample size of the importance weights; `paths` without
+    double weight_ess = 0.0;
+    // Regression coefficient of each control variate, in declaration order
+    std::vector<double> control_coefficients;
+};
+
+// When run_until stops: once the standard error of the mean of `variable`
+// at the final step is at most target_standard_error, or at the deadline,
+// or after n_subsimulations paths, whichever comes first. The error is that
+// of the importance-weighted paths, or antithetic pairs; strata and control
+// variates only lower it, so the rule errs on the side of more paths.
+struct StoppingRule {
+    std::string variable;
+    double target_standard_error = 0.0;
+    std::chrono::milliseconds time_limit{0};  // 0 = no deadline
+    std::size_t batch_size = 1000;            // Paths between checks
+    std::size_t min_paths = 100;              // Never stop on fewer
+};
+
+struct AdaptiveRunResult {
+    std::size_t paths = 0;         // Subsimulations actually run
+    double mean = 0.0;
+    double standard_error = 0.0;
+    bool converged = false;        // Stopped on the target, not the cap or deadline
+    std::chrono::milliseconds elapsed{0};
+};
+
+// Variable a streaming run accumulates
+struct StreamingTarget {
+    VariableLayout::Slot slot;
+    std::string name;
+};
+
+// Folds every step of a streamed path into one worker's accumulators
+struct StreamObserver {
+    const std::vector<StreamingTarget>* targets;
+    std::vector<StepAccumulator>* accumulators;
+
+    void operator()(const SubSimulationEnv& env, int step) const {
+        for (std::size_t k = 0; k < targets->size(); ++k) {
+            const auto& slot = (*targets)[k].slot;
+            double x;
+            switch (slot.kind) {
+                case ValueKind::Double: x = env.value(VarHandle<double>{slot.index}); break;
+                case ValueKind::Int: x = env.value(VarHandle<int>{slot.index}); break;
+                default: x = env.value(VarHandle<bool>{slot.index}) ? 1.0 : 0.0; break;
+            }
+            (*accumulators)[k].add(step, x);
+        }
+    }
+};
+
 class MonteCarloSimulationEnv {
 public:
     MonteCarloSimulationEnv(
         const std::vector<Variable>& variables,
         int n_subsimulations,
-        int n_steps
+        int n_steps,
+        int n_threads = 0,      // 0 = hardware concurrency
+        int chunk_size = 0      // subsimulations per work item, 0 = automatic
     );
 
+    // Register another variable and return its typed handle
+    template<typename T>
+    VarHandle<T> add_variable(const std::string& name, const T& default_value);
+
+    // Typed handle for a registered variable, for use in the callbacks
+    template<typename T>
+    VarHandle<T> handle(const std::string& var_name) const { return layout_->handle<T>(var_name); }
+
     // Direct setters for simulation functions
     void set_subsim_begin_callback(std::function<void(Context&)> f);
     void set_subsim_step_callback(std::function<void(Context&, int)> f);
 
+    // Statically dispatched alternative to the callbacks: a Model with
+    //   void begin(Context&);
+    //   void step(Context&, int step);
+    // whose calls inline into the step loop instead of going through
+    // std::function on every step. Each worker runs its own copy, so a
+    // model may keep scratch state. Replaces the callbacks until they are
+    // set again.
+    template<typename Model>
+    void set_model(const Model& model);
+
+    // Vector model: advances `lanes` paths at a time through PathBlock
+    // columns, one call per block and step instead of one per path:
+    //   void begin(PathBlock&);
+    //   void step(PathBlock&, int step);
+    // Lanes draw the same random numbers their paths would through
+    // Context::rng, and the run is stored, streamed, stopped and estimated
+    // like any other. Numeric variables only.
+    template<typename Model>
+    void set_vector_model(const Model& model, std::size_t lanes = 256);
+
+    // Point set for Context::uniform: subsimulation i gets point i, so a
+    // low-discrepancy sampler spreads the paths evenly over the random
+    // inputs. Points are generated a work item at a time. nullptr removes it.
+    void set_sampler(std::shared_ptr<const Sampler> sampler);
+
+    // Master seed of Context::rng; subsimulation i draws from Philox stream
+    // i under it, so a run is reproducible for any thread count
+    void set_seed(std::uint64_t seed) { seed_ = seed; }
+    std::uint64_t seed() const { return seed_; }
+
+    // Variance reduction. The techniques combine; get_variable_estimate
+    // accounts for all of them.
+    //
+    // Antithetic pairs: subsimulations 2k and 2k + 1 share random stream k,
+    // the second drawing it mirrored (1 - u, -z). Needs an even count.
+    void set_antithetic(bool antithetic) { antithetic_ = antithetic; }
+
+    // Stratification: paths (or antithetic pairs) are dealt round-robin to
+    // n_strata equal-probability strata; the begin callback reads its stratum
+    // through Context::stratum() or draws Context::stratified_uniform().
+    void set_strata(int n_strata);
+
+    // Control variate: a variable whose mean at every step is known. Its
+    // deviation from the expectation corrects the estimates of the other
+    // variables by regression.
+    void add_control_variate(const std::string& var_name, double expectation);
+    void clear_control_variates() { controls_.clear(); }
+
+    // Estimate of the mean of a variable at one step (-1 = the last), with
+    // importance weights, antithetic pairing, strata and control variates
+    // applied. Needs stored histories.
+    MonteCarloEstimate get_variable_estimate(const std::string& var_name, int step = -1);
+
+    // Streaming statistics: declare the statistics a variable needs before
+    // run(). Once any variable is streamed, paths are folded into per-worker
+    // accumulators and no histories are stored.
+    void stream_variable(const std::string& var_name, const StreamingSpec& spec = StreamingSpec());
+    void clear_streaming();
+    bool is_streaming() const { return !streaming_specs_.empty(); }
+
     // Run simulations
     void run(bool show_progress = true);
 
+    // Run paths in batches until the stopping rule holds, with
+    // n_subsimulations as the cap. Only the paths run are kept or streamed,
+    // and every statistic afterwards covers exactly those.
+    AdaptiveRunResult run_until(const StoppingRule& rule, bool show_progress = false);
+
+    // Subsimulations covered by the last run
+    std::size_t paths_run() const { return paths_run_; }
+
     // Get specific subsimulation environment
     SubSimulationEnv& get_subsim_env(int subsim_index);
 
-    // Statistical analysis functions
+    // Statistical analysis functions. get_variable_statistics computes any
+    // combination of them in a single pass over the data.
+    VariableStatistics get_variable_statistics(
+        const std::string& var_name,
+        unsigned stats = STAT_ALL,
+        const std::string& domain = "step"
+    );
     StatisticalResult get_variable_mean(const std::string& var_name, const std::string& domain = "step");
     StatisticalResult get_variable_median(const std::string& var_name, const std::string& domain = "step");
     StatisticalResult get_variable_variance(const std::string& var_name, const std::string& domain = "step");
@@ -45,6 +217,9 @@ public:
     StatisticalResult get_variable_max(const std::string& var_name, const std::string& domain = "step");
     StatisticalResult get_variable_sum(const std::string& var_name, const std::string& domain = "step");
 
+    // Per-step q-quantile; approximate (t-digest) in streaming mode
+    StatisticalResult get_variable_quantile(const std::string& var_name, double q);
+
     // Histogram generation
     struct HistogramResult {
         std::vector<std::vector<double>> counts;
@@ -63,14 +238,105 @@ public:
 
 private:
     std::vector<Variable> variables_;
+    std::shared_ptr<const VariableLayout> layout_;
     int n_subsims_;
     int n_steps_;
+    int chunk_size_;
+    std::unique_ptr<ThreadPool> pool_;
     std::function<void(Context&)> begin_function_;
     std::function<void(Context&, int)> step_function_;
+    std::shared_ptr<const Sampler> sampler_;
+    std::uint64_t seed_ = 0;
+    bool antithetic_ = false;
+    int n_strata_ = 1;
+    std::vector<std::pair<std::string, double>> controls_;
     std::vector<std::unique_ptr<SubSimulationEnv>> subsim_envs_;
+    std::map<std::string, StreamingSpec> streaming_specs_;
+    std::map<std::string, StepAccumulator> streaming_results_;
+    std::size_t paths_run_ = 0;
+
+    // Streaming state of the run in progress
+    std::vector<StreamingTarget> streaming_targets_;
+    std::vector<std::vector<StepAccumulator>> streaming_workers_;
+
+    // Called after each path of a batch with the env, its index and the worker
+    using PathCallback = std::function<void(const SubSimulationEnv&, std::size_t, int)>;
+
+    // Runs one whole path on a worker; type-erased per path, not per step.
+    // A vector model instead runs a PathBlock, calling the observer after
+    // every step.
+    using BlockObserver = std::function<void(PathBlock&, int)>;
+    struct PathKernel {
+        std::function<void(SubSimulationEnv&, int, int)> run;
+        std::function<void(SubSimulationEnv&, int, int, const StreamObserver&)> stream;
+        std::function<void(PathBlock&, int, int, const BlockObserver&)> block;
+        std::size_t lanes = 0;
+    };
+    PathKernel model_kernel_;   // From set_model; empty = use the callbacks
+    PathKernel active_kernel_;  // Kernel of the run in progress
 
     // Helper functions
+    void begin_run();
+    void run_batch(std::size_t first, std::size_t last, std::size_t chunk,
+                   const std::function<void(std::size_t)>& report, const PathCallback& on_path);
+    void end_run(std::size_t paths);
+    std::size_t default_chunk(std::size_t paths) const;
+    std::function<void(std::size_t)> progress_reporter(bool show_progress) const;
+    void fill_sample_points(std::size_t begin, std::size_t end, std::vector<double>& points) const;
+    void configure_path(SubSimulationEnv& env, std::size_t subsim) const;
+    void run_lanes(std::size_t first, std::size_t last, std::size_t chunk,
+                   const std::function<void(std::size_t)>& report, const PathCallback& on_path);
+
+    // Random stream, mirroring and stratum of a subsimulation
+    struct PathKey {
+        std::uint64_t stream;
+        bool antithetic;
+        int stratum;
+    };
+    PathKey path_key(std::size_t subsim) const;
+    StepAccumulator& streamed_statistics(const std::string& var_name);
     void validate_variable(const std::string& var_name) const;
     std::vector<std::vector<double>> collect_histories(const std::string& var_name) const;
+    std::vector<double> gather_step_major(const std::string& var_name) const;
+    std::vector<double> path_values(const std::string& var_name, int step) const;
 };
 
+template<typename Model>
+void MonteCarloSimulationEnv::set_model(const Model& model) {
+    auto models = std::make_shared<std::vector<Model>>(pool_->size(), model);
+    model_kernel_ = PathKernel();
+    model_kernel_.run = [models](SubSimulationEnv& env, int n_steps, int worker) {
+        env.runModel((*models)[worker], n_steps, [](const SubSimulationEnv&, int) {});
+    };
+    model_kernel_.stream = [models](SubSimulationEnv& env, int n_steps, int worker, const StreamObserver& observe) {
+        env.runModel((*models)[worker], n_steps, observe);
+    };
+}
+
+template<typename Model>
+void MonteCarloSimulationEnv::set_vector_model(const Model& model, std::size_t lanes) {
+    if (lanes == 0) throw std::invalid_argument("lanes must be positive");
+    auto models = std::make_shared<std::vector<Model>>(pool_->size(), model);
+    model_kernel_ = PathKernel();
+    model_kernel_.lanes = lanes;
+    model_kernel_.block = [models](PathBlock& block, int n_steps, int worker, const BlockObserver& observe) {
+        Model& m = (*models)[worker];
+        block.seek(SubSimulationEnv::beginPosition(0));
+        m.begin(block);
+        for (int step = 0; step < n_steps; ++step) {
+            block.seek(SubSimulationEnv::stepPosition(step));
+            m.step(block, step);
+            observe(block, step);
+        }
+    };
+}
+
+template<typename T>
+VarHandle<T> MonteCarloSimulationEnv::add_variable(const std::string& name, const T& default_value) {
+    auto variables = variables_;
+    variables.emplace_back(name, default_value);
+    layout_ = std::make_shared<const VariableLayout>(variables);
+    variables_ = std::move(variables);
+    return layout_->handle<T>(name);
+}
+
@@ -117,6 +117,7 @@ private:
             num_simulations_,
             num_steps_
         );
+        mc_env_->set_seed(42);  // Same seed as the comparison bot
 
         // Set callbacks
         mc_env_->set_subsim_begin_callback(
@@ -161,13 +162,14 @@ private:
         return state;
     }
 
-    size_t selectAction(const Context& ctx, const open_spiel::State& state) {
+    size_t selectAction(Context& ctx, const open_spiel::State& state) {
         auto legal_actions = state.LegalActions();
         if (legal_actions.empty()) return 0;
         
         // Implement your action selection logic here
         // You can use ctx to access your Monte Carlo statistics
-        return std::rand() % legal_actions.size();  // Placeholder
+        // Placeholder: uniform over the legal actions, from the path's own stream
+        return static_cast<size_t>(ctx.rng().uniform() * legal_actions.size());
     }
 
     GameStats collectStats(std::chrono::milliseconds duration) {
@@ -0,0 +1,149 @@
+#pragma once
+#include "subsim.hpp"
+#include "philox.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A block of paths advanced together by a vector model (see
+// MonteCarloSimulationEnv::set_vector_model).
+//
+// Every numeric variable is a column with one value per lane, so a step is
+// a loop over lanes that the compiler can vectorize, not a call per path.
+// Lane l is subsimulation first() + l. Its random draws are the ones that
+// path would get through Context::rng(): the k-th fill of a step reads block
+// k of the path's stream at that step. Scalar and vector runs of the same
+// model therefore produce the same paths.
+class PathBlock {
+public:
+    PathBlock(std::shared_ptr<const VariableLayout> layout, std::size_t capacity)
+        : layout_(std::move(layout)), capacity_(capacity) {
+        if (capacity == 0) throw std::invalid_argument("PathBlock needs at least one lane");
+        if (layout_->count(ValueKind::String) > 0)
+            throw std::invalid_argument("Vector models need numeric variables only");
+        doubles_.assign(layout_->count(ValueKind::Double) * capacity, 0.0);
+        ints_.assign(layout_->count(ValueKind::Int) * capacity, 0);
+        bools_.reset(new bool[layout_->count(ValueKind::Bool) * capacity]());
+        weights_.assign(capacity, 1.0);
+        streams_.assign(capacity, 0);
+        mirror_.assign(capacity, 0.0);
+        strata_index_.assign(capacity, 0);
+        u0_.resize(capacity);
+        u1_.resize(capacity);
+    }
+
+    PathBlock(const PathBlock&) = delete;
+    PathBlock& operator=(const PathBlock&) = delete;
+
+    // Lanes in use, and the subsimulation of lane 0
+    std::size_t size() const { return size_; }
+    std::uint64_t first() const { return first_; }
+
+    // Column of one variable, size() values
+    double* column(VarHandle<double> var) { return &doubles_[var.slot * capacity_]; }
+    int* column(VarHandle<int> var) { return &ints_[var.slot * capacity_]; }
+    bool* column(VarHandle<bool> var) { return &bools_[var.slot * capacity_]; }
+    const double* column(VarHandle<double> var) const { return &doubles_[var.slot * capacity_]; }
+    const int* column(VarHandle<int> var) const { return &ints_[var.slot * capacity_]; }
+    const bool* column(VarHandle<bool> var) const { return &bools_[var.slot * capacity_]; }
+
+    // out[l] for every lane, one draw from lane l's stream: uniform in
+    // (0, 1), or standard normal by the Box-Muller cosine branch
+    void fill_uniform(double* out) {
+        draw();
+        for (std::size_t l = 0; l < size_; ++l) out[l] = u0_[l] + mirror_[l] * (1.0 - 2.0 * u0_[l]);
+    }
+
+    void fill_normal(double* out) {
+        draw();
+        for (std::size_t l = 0; l < size_; ++l) {
+            const double sign = 1.0 - 2.0 * mirror_[l];
+            out[l] = sign * std::sqrt(-2.0 * std::log(u0_[l])) * std::cos(philox_detail::TWO_PI * u1_[l]);
+        }
+    }
+
+    // Variance-reduction hooks, as on Context: stratum of a lane, and the
+    // lanes' likelihood ratios, 1 at the start of every path
+    int stratum(std::size_t lane) const { return strata_index_[lane]; }
+    int strata() const { return strata_; }
+    double* weights() { return weights_.data(); }
+    const double* weights() const { return weights_.data(); }
+
+    // Coordinate dim of a lane's sampler point, as Context::uniform
+    double uniform(std::size_t lane, int dim) const {
+        if (dim < 0 || dim >= dims_)
+            throw std::out_of_range(dims_ == 0
+                ? "No sampler point; call set_sampler before run"
+                : "Sampler dimension " + std::to_string(dim) + " out of range");
+        return points_[lane * dims_ + dim];
+    }
+
+    // Engine side: start() resets lanes to paths first .. first + n - 1 at
+    // their default values, setPath() keys each lane's stream and stratum
+    void start(std::uint64_t first, std::size_t n, std::uint64_t seed) {
+        if (n > capacity_) throw std::invalid_argument("More paths than PathBlock lanes");
+        first_ = first;
+        size_ = n;
+        seed_ = seed;
+        for (int id = 0; id < layout_->size(); ++id) {
+            const auto& slot = layout_->slot(id);
+            const auto& value = layout_->variables()[id].default_value;
+            const std::size_t base = slot.index * capacity_;
+            switch (slot.kind) {
+                case ValueKind::Double: std::fill_n(&doubles_[base], n, std::get<double>(value)); break;
+                case ValueKind::Int: std::fill_n(&ints_[base], n, std::get<int>(value)); break;
+                case ValueKind::Bool: std::fill_n(&bools_[base], n, std::get<bool>(value)); break;
+                case ValueKind::String: break;
+            }
+        }
+        std::fill_n(weights_.begin(), n, 1.0);
+    }
+
+    void setPath(std::size_t lane, std::uint64_t stream, bool antithetic, int stratum, int strata) {
+        streams_[lane] = stream;
+        mirror_[lane] = antithetic ? 1.0 : 0.0;
+        strata_index_[lane] = stratum;
+        strata_ = strata;
+    }
+
+    // Sampler points of the lanes, dims per lane; copied
+    void setSamplePoints(const double* points, int dims) {
+        dims_ = dims;
+        points_.assign(points, points + size_ * dims);
+    }
+
+    // Position the lanes' streams for the begin callback or a step
+    void seek(std::uint64_t position) { position_ = position; }
+
+private:
+    // Next block of every lane's stream into u0_, u1_
+    void draw() {
+        PhiloxStream::fill_across(seed_, position_++, streams_.data(), size_, u0_.data(), u1_.data());
+    }
+
+    std::shared_ptr<const VariableLayout> layout_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+    std::uint64_t first_ = 0;
+
+    std::vector<double> doubles_;  // Column c at [c * capacity_, (c + 1) * capacity_)
+    std::vector<int> ints_;
+    std::unique_ptr<bool[]> bools_;
+    std::vector<double> weights_;
+
+    std::uint64_t seed_ = 0;
+    std::uint64_t position_ = 0;
+    std::vector<std::uint64_t> streams_;
+    std::vector<double> mirror_;  // 1 for antithetic lanes, as a double so the draw loops vectorize
+    std::vector<int> strata_index_;
+    int strata_ = 1;
+    std::vector<double> u0_, u1_;
+
+    int dims_ = 0;
+    std::vector<double> points_;
+};
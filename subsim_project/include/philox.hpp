@@ -0,0 +1,214 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random
+// Numbers: As Easy as 1, 2, 3", SC11).
+//
+// Output is a pure function of a 128-bit counter and a 64-bit key, so any
+// draw of any stream can be produced directly, in any order, on any thread.
+// A PhiloxStream uses the seed as key, a 64-bit stream id as the high half
+// of the counter and the draw index as the low half: streams never overlap,
+// skipping ahead is an addition, and a batch of draws is a loop of
+// independent blocks the compiler can vectorize.
+namespace philox_detail {
+
+const std::uint32_t MULTIPLIER_0 = 0xD2511F53u;
+const std::uint32_t MULTIPLIER_1 = 0xCD9E8D57u;
+const std::uint32_t WEYL_0 = 0x9E3779B9u;
+const std::uint32_t WEYL_1 = 0xBB67AE85u;
+
+// One 4x32 block, in place: c holds the counter on entry and the output on exit
+inline void block(std::uint32_t& c0, std::uint32_t& c1, std::uint32_t& c2, std::uint32_t& c3,
+                  std::uint32_t k0, std::uint32_t k1) {
+#pragma GCC unroll 10
+    for (int round = 0; round < 10; ++round) {
+        std::uint64_t p0 = static_cast<std::uint64_t>(MULTIPLIER_0) * c0;
+        std::uint64_t p1 = static_cast<std::uint64_t>(MULTIPLIER_1) * c2;
+        std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        std::uint32_t n1 = static_cast<std::uint32_t>(p1);
+        std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        std::uint32_t n3 = static_cast<std::uint32_t>(p0);
+        c0 = n0;
+        c1 = n1;
+        c2 = n2;
+        c3 = n3;
+        k0 += WEYL_0;
+        k1 += WEYL_1;
+    }
+}
+
+// Uniform double in (0, 1) from the top 52 of 64 random bits, built in the
+// exponent of [1, 2) so the conversion vectorizes without 64-bit integer to
+// double instructions, and offset by half a step to exclude 0
+inline double to_unit(std::uint32_t hi, std::uint32_t lo) {
+    std::uint64_t bits = (static_cast<std::uint64_t>(hi) << 32 | lo) >> 12 | 0x3FF0000000000000ULL;
+    double x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return (x - 1.0) + 0.5 / 4503599627370496.0;
+}
+
+const double TWO_PI = 6.283185307179586476925286766559;
+
+} // namespace philox_detail
+
+class PhiloxStream {
+public:
+    // Blocks per inner batch of fill_uniform; the scratch stays on the stack
+    static const std::size_t BLOCK = 128;
+
+    explicit PhiloxStream(std::uint64_t seed = 0, std::uint64_t stream = 0, std::uint64_t position = 0)
+        : seed_(seed), stream_(stream), position_(position) {}
+
+    std::uint64_t seed() const { return seed_; }
+    std::uint64_t stream() const { return stream_; }
+
+    // An antithetic stream draws the same blocks mirrored: 1 - u for every
+    // uniform and -z for every normal
+    void setAntithetic(bool antithetic) { antithetic_ = antithetic; }
+    bool antithetic() const { return antithetic_; }
+
+    // Index of the next block; each block yields two doubles
+    std::uint64_t position() const { return position_; }
+    void seek(std::uint64_t position) { position_ = position; }
+    void skip(std::uint64_t blocks) { position_ += blocks; }
+
+    // Next uniform in (0, 1). Each call consumes a whole block, so scalar and
+    // batched draws of the same stream do not interleave; use fill_uniform
+    // for throughput.
+    double uniform() {
+        double u[2];
+        generate(position_++, u);
+        return antithetic_ ? 1.0 - u[0] : u[0];
+    }
+
+    // out[i] for i < n, uniform in (0, 1); consumes (n + 1) / 2 blocks. The
+    // same draws as repeated calls on a stream positioned alike would give,
+    // in pairs.
+    void fill_uniform(double* out, std::size_t n) {
+        fill_raw(out, n);
+        if (antithetic_) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = 1.0 - out[i];
+        }
+    }
+
+    // Uniform in [a, b)
+    void fill_uniform(double* out, std::size_t n, double a, double b) {
+        fill_uniform(out, n);
+        const double width = b - a;
+        for (std::size_t i = 0; i < n; ++i) out[i] = a + width * out[i];
+    }
+
+    // Standard normal from one block (Box-Muller, cosine branch)
+    double normal() {
+        double u[2];
+        generate(position_++, u);
+        const double z = std::sqrt(-2.0 * std::log(u[0])) * std::cos(philox_detail::TWO_PI * u[1]);
+        return antithetic_ ? -z : z;
+    }
+
+    // out[i] for i < n, standard normal; consumes (n + 1) / 2 blocks, like
+    // fill_uniform. Each pair of uniforms becomes a pair of normals by
+    // Box-Muller, transformed in place in a separate loop so it vectorizes
+    // where the math library has vector variants of log, sin and cos.
+    void fill_normal(double* out, std::size_t n) {
+        const std::size_t pairs = n / 2;
+        const double sign = antithetic_ ? -1.0 : 1.0;
+        fill_raw(out, 2 * pairs);
+        for (std::size_t i = 0; i < pairs; ++i) {
+            const double r = sign * std::sqrt(-2.0 * std::log(out[2 * i]));
+            const double theta = philox_detail::TWO_PI * out[2 * i + 1];
+            out[2 * i] = r * std::cos(theta);
+            out[2 * i + 1] = r * std::sin(theta);
+        }
+        if (n % 2 != 0) out[n - 1] = normal();
+    }
+
+    // Normal with the given mean and standard deviation
+    void fill_normal(double* out, std::size_t n, double mean, double stddev) {
+        fill_normal(out, n);
+        for (std::size_t i = 0; i < n; ++i) out[i] = mean + stddev * out[i];
+    }
+
+    // Block `position` of each of n streams of one seed: u0[i] and u1[i] are
+    // the two doubles of that block of stream streams[i], unmirrored, as
+    // generate() would give them. For lanes of paths that advance in step.
+    static void fill_across(std::uint64_t seed, std::uint64_t position, const std::uint64_t* streams,
+                            std::size_t n, double* u0, double* u1) {
+        std::uint32_t r0[BLOCK], r1[BLOCK], r2[BLOCK], r3[BLOCK];
+        const std::uint32_t k0 = static_cast<std::uint32_t>(seed), k1 = static_cast<std::uint32_t>(seed >> 32);
+        const std::uint32_t p0 = static_cast<std::uint32_t>(position), p1 = static_cast<std::uint32_t>(position >> 32);
+
+        for (std::size_t base = 0; base < n; base += BLOCK) {
+            const std::size_t m = n - base < BLOCK ? n - base : BLOCK;
+            const std::uint64_t* s = streams + base;
+            for (std::size_t i = 0; i < m; ++i) {
+                std::uint32_t c0 = p0, c1 = p1;
+                std::uint32_t c2 = static_cast<std::uint32_t>(s[i]);
+                std::uint32_t c3 = static_cast<std::uint32_t>(s[i] >> 32);
+                philox_detail::block(c0, c1, c2, c3, k0, k1);
+                r0[i] = c0;
+                r1[i] = c1;
+                r2[i] = c2;
+                r3[i] = c3;
+            }
+            for (std::size_t i = 0; i < m; ++i) {
+                u0[base + i] = philox_detail::to_unit(r0[i], r1[i]);
+                u1[base + i] = philox_detail::to_unit(r2[i], r3[i]);
+            }
+        }
+    }
+
+private:
+    // Unmirrored uniforms. Blocks are generated into stack scratch and
+    // converted in a second loop so both loops vectorize.
+    void fill_raw(double* out, std::size_t n) {
+        std::uint32_t r0[BLOCK], r1[BLOCK], r2[BLOCK], r3[BLOCK];
+        const std::uint32_t k0 = static_cast<std::uint32_t>(seed_), k1 = static_cast<std::uint32_t>(seed_ >> 32);
+        const std::uint32_t s0 = static_cast<std::uint32_t>(stream_), s1 = static_cast<std::uint32_t>(stream_ >> 32);
+        const std::size_t pairs = n / 2;
+
+        for (std::size_t base = 0; base < pairs; base += BLOCK) {
+            const std::size_t m = pairs - base < BLOCK ? pairs - base : BLOCK;
+            const std::uint64_t first = position_ + base;
+            for (std::size_t i = 0; i < m; ++i) {
+                std::uint32_t c0 = static_cast<std::uint32_t>(first + i);
+                std::uint32_t c1 = static_cast<std::uint32_t>((first + i) >> 32);
+                std::uint32_t c2 = s0, c3 = s1;
+                philox_detail::block(c0, c1, c2, c3, k0, k1);
+                r0[i] = c0;
+                r1[i] = c1;
+                r2[i] = c2;
+                r3[i] = c3;
+            }
+            double* o = out + 2 * base;
+            for (std::size_t i = 0; i < m; ++i) {
+                o[2 * i] = philox_detail::to_unit(r0[i], r1[i]);
+                o[2 * i + 1] = philox_detail::to_unit(r2[i], r3[i]);
+            }
+        }
+        position_ += pairs;
+        if (n % 2 != 0) {
+            double u[2];
+            generate(position_++, u);
+            out[n - 1] = u[0];
+        }
+    }
+
+    void generate(std::uint64_t position, double* out) const {
+        std::uint32_t c0 = static_cast<std::uint32_t>(position);
+        std::uint32_t c1 = static_cast<std::uint32_t>(position >> 32);
+        std::uint32_t c2 = static_cast<std::uint32_t>(stream_);
+        std::uint32_t c3 = static_cast<std::uint32_t>(stream_ >> 32);
+        philox_detail::block(c0, c1, c2, c3, static_cast<std::uint32_t>(seed_), static_cast<std::uint32_t>(seed_ >> 32));
+        out[0] = philox_detail::to_unit(c0, c1);
+        out[1] = philox_detail::to_unit(c2, c3);
+    }
+
+    std::uint64_t seed_;
+    std::uint64_t stream_;
+    std::uint64_t position_;
+    bool antithetic_ = false;
+};
@@ -0,0 +1,369 @@
+#pragma once
+#include "philox.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Point sets on the unit cube for Monte Carlo and quasi-Monte Carlo.
+//
+// A Sampler is a fixed sequence of points in (0, 1)^dimensions(), addressed
+// by index: fill(first, n, out) writes points first .. first + n - 1, with
+// coordinate d of point i at out[(i - first) * dimensions() + d]. Since
+// points are addressed by index, skipping ahead is free and threads can work
+// on disjoint blocks of one sequence. reseeded() gives an independent
+// randomization of the same construction, for replicate-based error
+// estimates.
+//
+// PhiloxSampler    pseudo-random points, the baseline
+// SobolSampler     Sobol' points (Joe-Kuo direction numbers), optionally
+//                  with hash-based Owen scrambling (Laine-Karras / Burley)
+// HaltonSampler    Halton points, optionally with random digit scrambling
+class Sampler {
+public:
+    virtual ~Sampler() = default;
+
+    virtual int dimensions() const = 0;
+    virtual void fill(std::uint64_t first, std::size_t n, double* out) const = 0;
+    virtual std::unique_ptr<Sampler> reseeded(std::uint64_t seed) const = 0;
+};
+
+namespace qmc_detail {
+
+// splitmix64 finaliser, to derive per-dimension seeds
+inline std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline std::uint32_t reverse_bits(std::uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// Nested uniform (Owen) scramble of a 32-bit fixed-point coordinate:
+// Laine-Karras permutation of the bit-reversed value, as in Burley,
+// "Practical Hash-based Owen Scrambling" (JCGT 2020)
+inline std::uint32_t owen_scramble(std::uint32_t x, std::uint32_t seed) {
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverse_bits(x);
+}
+
+// Fixed point to (0, 1), at the centre of its 2^-32 cell
+inline double to_unit(std::uint32_t x) {
+    return (static_cast<double>(x) + 0.5) * (1.0 / 4294967296.0);
+}
+
+// Joe-Kuo new-joe-kuo-6.21201 parameters for dimensions 2 .. 21: degree s
+// of the primitive polynomial, its coefficients a and initial m_1 .. m_s
+struct SobolParameters {
+    int s;
+    std::uint32_t a;
+    std::uint32_t m[7];
+};
+
+const SobolParameters JOE_KUO[] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7, 1, {1, 3, 7, 11, 23, 15, 103}},
+    {7, 4, {1, 3, 7, 13, 13, 15, 69}},
+};
+const int JOE_KUO_DIMENSIONS = 1 + static_cast<int>(sizeof(JOE_KUO) / sizeof(JOE_KUO[0]));
+
+} // namespace qmc_detail
+
+class PhiloxSampler : public Sampler {
+public:
+    PhiloxSampler(int dimensions, std::uint64_t seed = 0) : dimensions_(dimensions), seed_(seed) {
+        if (dimensions < 1) throw std::invalid_argument("Sampler needs at least one dimension");
+    }
+
+    int dimensions() const override { return dimensions_; }
+
+    // Point i is the start of Philox stream i
+    void fill(std::uint64_t first, std::size_t n, double* out) const override {
+        for (std::size_t i = 0; i < n; ++i) {
+            PhiloxStream(seed_, first + i).fill_uniform(out + i * dimensions_, dimensions_);
+        }
+    }
+
+    std::unique_ptr<Sampler> reseeded(std::uint64_t seed) const override {
+        return std::make_unique<PhiloxSampler>(dimensions_, seed);
+    }
+
+private:
+    int dimensions_;
+    std::uint64_t seed_;
+};
+
+class SobolSampler : public Sampler {
+public:
+    enum class Scramble { None, Owen };
+
+    // Built-in direction numbers cover 21 dimensions; load the full Joe-Kuo
+    // file with the other constructor for more
+    SobolSampler(int dimensions, Scramble scramble = Scramble::Owen, std::uint64_t seed = 0)
+        : dimensions_(dimensions), scramble_(scramble), seed_(seed) {
+        if (dimensions < 1) throw std::invalid_argument("Sampler needs at least one dimension");
+        if (dimensions > qmc_detail::JOE_KUO_DIMENSIONS)
+            throw std::invalid_argument("SobolSampler has built-in direction numbers for "
+                + std::to_string(qmc_detail::JOE_KUO_DIMENSIONS) + " dimensions; pass a direction number file");
+        auto directions = std::make_shared<std::vector<std::uint32_t>>();
+        for (int d = 0; d < dimensions; ++d) {
+            if (d == 0) {
+                appendDirections(*directions, 0, 0, nullptr);
+            } else {
+                const auto& p = qmc_detail::JOE_KUO[d - 1];
+                appendDirections(*directions, p.s, p.a, p.m);
+            }
+        }
+        directions_ = directions;
+        initSeeds();
+    }
+
+    // Direction numbers from a file in the Joe-Kuo format ("d s a m_i ..."
+    // per line after a header line), e.g. new-joe-kuo-6.21201
+    SobolSampler(int dimensions, const std::string& direction_file,
+                 Scramble scramble = Scramble::Owen, std::uint64_t seed = 0)
+        : dimensions_(dimensions), scramble_(scramble), seed_(seed) {
+        if (dimensions < 1) throw std::invalid_argument("Sampler needs at least one dimension");
+        std::ifstream in(direction_file);
+        if (!in) throw std::runtime_error("Cannot open direction numbers: " + direction_file);
+
+        auto directions = std::make_shared<std::vector<std::uint32_t>>();
+        appendDirections(*directions, 0, 0, nullptr);
+        std::string line;
+        std::getline(in, line);  // Header
+        while (static_cast<int>(directions->size()) < dimensions * BITS && std::getline(in, line)) {
+            std::istringstream fields(line);
+            int d, s;
+            std::uint32_t a, m[32];
+            if (!(fields >> d >> s >> a) || s < 1 || s > 31) continue;
+            for (int k = 0; k < s; ++k) fields >> m[k];
+            if (!fields) throw std::runtime_error("Malformed direction numbers in " + direction_file);
+            appendDirections(*directions, s, a, m);
+        }
+        if (static_cast<int>(directions->size()) < dimensions * BITS)
+            throw std::runtime_error(direction_file + " has fewer than " + std::to_string(dimensions) + " dimensions");
+        directions_ = directions;
+        initSeeds();
+    }
+
+    int dimensions() const override { return dimensions_; }
+
+    // Points in Gray-code order: the first point is computed directly, the
+    // rest by one XOR per coordinate (Antonov-Saleev)
+    void fill(std::uint64_t first, std::size_t n, double* out) const override {
+        if (n == 0) return;
+        // first + n <= 2^32, written so that neither side can overflow
+        const std::uint64_t limit = 1ull << BITS;
+        if (first > limit || n > limit - first)
+            throw std::out_of_range("SobolSampler supports 2^32 points");
+        const std::uint32_t* v = directions_->data();
+        std::vector<std::uint32_t> x(dimensions_, 0);
+
+        std::uint32_t gray = static_cast<std::uint32_t>(first ^ (first >> 1));
+        for (int bit = 0; gray != 0; ++bit, gray >>= 1) {
+            if (gray & 1u) {
+                for (int d = 0; d < dimensions_; ++d) x[d] ^= v[d * BITS + bit];
+            }
+        }
+
+        std::uint64_t index = first;
+        for (std::size_t i = 0; i < n; ++i, ++index) {
+            double* point = out + i * dimensions_;
+            if (scramble_ == Scramble::Owen) {
+                for (int d = 0; d < dimensions_; ++d) point[d] = qmc_detail::to_unit(qmc_detail::owen_scramble(x[d], seeds_[d]));
+            } else {
+                for (int d = 0; d < dimensions_; ++d) point[d] = qmc_detail::to_unit(x[d]);
+            }
+            // Next point: flip the direction of the lowest zero bit of index.
+            // After point 2^32 - 1 that would be direction 32, past the table.
+            if (i + 1 == n) break;
+            int bit = __builtin_ctzll(~index);
+            for (int d = 0; d < dimensions_; ++d) x[d] ^= v[d * BITS + bit];
+        }
+    }
+
+    std::unique_ptr<Sampler> reseeded(std::uint64_t seed) const override {
+        auto copy = std::make_unique<SobolSampler>(*this);
+        copy->seed_ = seed;
+        copy->initSeeds();
+        return copy;
+    }
+
+private:
+    static const int BITS = 32;
+
+    // Direction numbers v_1 .. v_32 of one dimension, scaled to 32 bits,
+    // from the primitive polynomial of degree s with coefficients a. s = 0
+    // gives the first dimension, the van der Corput sequence.
+    static void appendDirections(std::vector<std::uint32_t>& v, int s, std::uint32_t a, const std::uint32_t* m) {
+        const std::size_t base = v.size();
+        v.resize(base + BITS);
+        std::uint32_t* dir = v.data() + base;
+        if (s == 0) {
+            for (int i = 0; i < BITS; ++i) dir[i] = 1u << (BITS - 1 - i);
+            return;
+        }
+        for (int i = 0; i < s && i < BITS; ++i) dir[i] = m[i] << (BITS - 1 - i);
+        for (int i = s; i < BITS; ++i) {
+            dir[i] = dir[i - s] ^ (dir[i - s] >> s);
+            for (int k = 1; k < s; ++k) {
+                if ((a >> (s - 1 - k)) & 1u) dir[i] ^= dir[i - k];
+            }
+        }
+    }
+
+    void initSeeds() {
+        seeds_.resize(dimensions_);
+        for (int d = 0; d < dimensions_; ++d) {
+            seeds_[d] = static_cast<std::uint32_t>(qmc_detail::mix(seed_ ^ qmc_detail::mix(static_cast<std::uint64_t>(d))));
+        }
+    }
+
+    int dimensions_;
+    Scramble scramble_;
+    std::uint64_t seed_;
+    // Shared between reseeded copies; dimension d at [d * BITS, (d + 1) * BITS)
+    std::shared_ptr<const std::vector<std::uint32_t>> directions_;
+    std::vector<std::uint32_t> seeds_;
+};
+
+class HaltonSampler : public Sampler {
+public:
+    // Dimension d uses the (d + 1)-th prime as base. Scrambled points
+    // permute the digits with an independent random permutation per digit
+    // position and dimension (Matousek's random digit scrambling), over as
+    // many digits as a double resolves; this also breaks the correlation
+    // between high dimensions with nearby bases.
+    HaltonSampler(int dimensions, bool scrambled = true, std::uint64_t seed = 0)
+        : dimensions_(dimensions), scrambled_(scrambled), seed_(seed) {
+        if (dimensions < 1) throw std::invalid_argument("Sampler needs at least one dimension");
+        for (std::uint32_t candidate = 2; static_cast<int>(bases_.size()) < dimensions; ++candidate) {
+            bool prime = true;
+            for (std::uint32_t p : bases_) {
+                if (p * p > candidate) break;
+                if (candidate % p == 0) {
+                    prime = false;
+                    break;
+                }
+            }
+            if (prime) bases_.push_back(candidate);
+        }
+        for (std::uint32_t b : bases_) {
+            int digits = 0;
+            for (double scale = 1.0; scale > 0x1p-53; scale /= b) ++digits;
+            digits_.push_back(digits);
+        }
+        initPermutations();
+    }
+
+    int dimensions() const override { return dimensions_; }
+
+    // Point i is the radical inverse of i + 1, so no unscrambled coordinate is 0
+    void fill(std::uint64_t first, std::size_t n, double* out) const override {
+        for (std::size_t i = 0; i < n; ++i) {
+            double* point = out + i * dimensions_;
+            for (int d = 0; d < dimensions_; ++d) {
+                point[d] = scrambled_ ? scrambledInverse(d, first + i + 1) : radicalInverse(d, first + i + 1);
+            }
+        }
+    }
+
+    std::unique_ptr<Sampler> reseeded(std::uint64_t seed) const override {
+        auto copy = std::make_unique<HaltonSampler>(*this);
+        copy->seed_ = seed;
+        copy->initPermutations();
+        return copy;
+    }
+
+private:
+    double radicalInverse(int d, std::uint64_t k) const {
+        const std::uint32_t b = bases_[d];
+        const double inv_b = 1.0 / b;
+        double scale = inv_b, value = 0.0;
+        for (; k != 0; k /= b) {
+            value += static_cast<double>(k % b) * scale;
+            scale *= inv_b;
+        }
+        return value;
+    }
+
+    // Every digit position is permuted, including the zeros past the last
+    // digit of k, so the sum runs over all digits_[d] positions
+    double scrambledInverse(int d, std::uint64_t k) const {
+        const std::uint32_t b = bases_[d];
+        const std::uint32_t* perm = &permutations_[offsets_[d]];
+        const double inv_b = 1.0 / b;
+        double scale = inv_b, value = 0.0;
+        for (int position = 0; position < digits_[d]; ++position, perm += b) {
+            value += static_cast<double>(perm[k % b]) * scale;
+            scale *= inv_b;
+            k /= b;
+        }
+        // Centre of the last cell, so no coordinate is exactly 0
+        return value + 0.5 * scale * b;
+    }
+
+    // Fisher-Yates shuffles of 0 .. b-1, one per digit position
+    void initPermutations() {
+        offsets_.clear();
+        permutations_.clear();
+        if (!scrambled_) return;
+        for (int d = 0; d < dimensions_; ++d) {
+            const std::uint32_t b = bases_[d];
+            offsets_.push_back(permutations_.size());
+            PhiloxStream stream(seed_, static_cast<std::uint64_t>(d));
+            for (int position = 0; position < digits_[d]; ++position) {
+                const std::size_t base = permutations_.size();
+                for (std::uint32_t digit = 0; digit < b; ++digit) permutations_.push_back(digit);
+                std::uint32_t* perm = &permutations_[base];
+                for (std::uint32_t j = b - 1; j > 0; --j) {
+                    std::uint32_t k = static_cast<std::uint32_t>(stream.uniform() * (j + 1));
+                    std::uint32_t t = perm[j];
+                    perm[j] = perm[k];
+                    perm[k] = t;
+                }
+            }
+        }
+    }
+
+    int dimensions_;
+    bool scrambled_;
+    std::uint64_t seed_;
+    std::vector<std::uint32_t> bases_;
+    std::vector<int> digits_;  // Digits of base bases_[d] a double resolves
+    std::vector<std::size_t> offsets_;
+    std::vector<std::uint32_t> permutations_;
+};
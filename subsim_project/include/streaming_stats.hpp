@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Online count/mean/variance/min/max (Welford), mergeable across workers
+struct RunningMoments {
+    std::uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    void add(double x) {
+        ++count;
+        double delta = x - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (x - mean);
+        if (x < min) min = x;
+        if (x > max) max = x;
+    }
+
+    // Adds x[0, n) as one block: the block's own mean and squared deviations
+    // in two loops that vectorize, then one pairwise merge
+    void add(const double* x, std::size_t n);
+
+    void merge(const RunningMoments& other);
+
+    // Population variance, matching the stored-history statistics
+    double variance() const { return count ? m2 / static_cast<double>(count) : 0.0; }
+    double sum() const { return mean * static_cast<double>(count); }
+};
+
+// Merging t-digest (Dunning & Ertl) for approximate quantiles in bounded
+// memory. Unlike P-square markers, two digests merge without loss, so each
+// worker can keep its own and they are combined once at the end of a run.
+class TDigest {
+public:
+    explicit TDigest(double compression = 100.0);
+
+    void add(double x);
+    void merge(const TDigest& other);
+
+    // Approximate q-quantile, q in [0, 1]
+    double quantile(double q);
+
+    double count() const { return total_weight_ + static_cast<double>(buffer_.size()); }
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    void compress();
+
+    double compression_;
+    std::size_t buffer_limit_;  // Values buffered before a compress; kept explicitly since copies drop capacity
+    std::vector<Centroid> centroids_;
+    std::vector<double> buffer_;
+    double total_weight_ = 0.0;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = std::numeric_limits<double>::lowest();
+};
+
+// Statistics a streaming run accumulates for a variable
+enum StreamingStat : unsigned {
+    STREAM_MOMENTS = 1u << 0,    // mean, variance, stddev, min, max, sum
+    STREAM_HISTOGRAM = 1u << 1,  // fixed-range histogram, needs n_bins and range
+    STREAM_QUANTILES = 1u << 2   // t-digest quantiles, including the median
+};
+
+struct StreamingSpec {
+    unsigned stats = STREAM_MOMENTS;
+    int n_bins = 0;
+    std::pair<double, double> range = {0.0, 0.0};
+    double compression = 100.0;
+};
+
+// Per-step accumulators for one variable. Memory depends on the number of
+// steps and the spec, never on the number of paths.
+class StepAccumulator {
+public:
+    StepAccumulator(int n_steps, const StreamingSpec& spec);
+
+    void add(int step, double x) {
+        moments_[step].add(x);
+        if (!counts_.empty()) addToHistogram(step, x);
+        if (!digests_.empty()) digests_[step].add(x);
+    }
+
+    // The values of one step across a block of paths
+    void add(int step, const double* x, std::size_t n) {
+        moments_[step].add(x, n);
+        if (!counts_.empty()) {
+            for (std::size_t i = 0; i < n; ++i) addToHistogram(step, x[i]);
+        }
+        if (!digests_.empty()) {
+            for (std::size_t i = 0; i < n; ++i) digests_[step].add(x[i]);
+        }
+    }
+
+    void merge(const StepAccumulator& other);
+
+    const StreamingSpec& spec() const { return spec_; }
+    int steps() const { return static_cast<int>(moments_.size()); }
+    const RunningMoments& moments(int step) const { return moments_[step]; }
+    const std::uint64_t* histogram(int step) const { return &counts_[static_cast<std::size_t>(step) * spec_.n_bins]; }
+    TDigest& digest(int step) { return digests_[step]; }
+
+private:
+    void addToHistogram(int step, double x);
+
+    StreamingSpec spec_;
+    std::vector<RunningMoments> moments_;
+    std::vector<std::uint64_t> counts_;  // n_steps x n_bins, row-major
+    std::vector<TDigest> digests_;
+};
@@ -2,30 +2,175 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <memory>
 #include <variant>
 #include <any>
+#include <tuple>
+#include <utility>
+#include <cstddef>
 #include <stdexcept>
 #include <typeinfo>
 #include <iostream>
+#include <cstdint>
+#include "philox.hpp"
 
 // Forward declarations
 class Context;
+class PastState;
 class SubSimulationEnv;
+class Sampler;
 
 // Type alias for variant to handle multiple types
 using ValueType = std::variant<int, double, bool, std::string>;
 
-// Structure to hold variable information
+// Storage kind of a variable, in ValueType alternative order
+enum class ValueKind { Int = 0, Double = 1, Bool = 2, String = 3 };
+
+template<typename T> struct ValueKindOf;
+template<> struct ValueKindOf<int> { static constexpr ValueKind value = ValueKind::Int; };
+template<> struct ValueKindOf<double> { static constexpr ValueKind value = ValueKind::Double; };
+template<> struct ValueKindOf<bool> { static constexpr ValueKind value = ValueKind::Bool; };
+template<> struct ValueKindOf<std::string> { static constexpr ValueKind value = ValueKind::String; };
+
+// Typed index of a registered variable. Reading or writing through a handle
+// is a plain array access; the type is checked when the handle is created.
+template<typename T>
+struct VarHandle {
+    using value_type = T;
+    int slot = -1;  // position among the variables of the same kind
+    int id = -1;    // position in the registration order
+
+    bool valid() const { return slot >= 0; }
+};
+
+// Structure to hold variable information. lookback is the largest n the
+// model reads through Context::past(n); it lets the variable's lagged values
+// be kept when the full history is not.
 struct Variable {
     std::string name;
     const std::type_info& type;
     ValueType default_value;
-    
+    int lookback;
+
     template<typename T>
-    Variable(const std::string& n, const T& default_val)
-        : name(n), type(typeid(T)), default_value(default_val) {}
+    Variable(const std::string& n, const T& default_val, int max_lookback = 0)
+        : name(n), type(typeid(T)), default_value(default_val), lookback(max_lookback) {}
+};
+
+// Read-only, zero-copy view over a contiguous run of values
+template<typename T>
+class HistoryView {
+private:
+    const T* data_;
+    std::size_t size_;
+
+public:
+    HistoryView(const T* data = nullptr, std::size_t size = 0) : data_(data), size_(size) {}
+
+    const T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    const T& front() const { return data_[0]; }
+    const T& back() const { return data_[size_ - 1]; }
+};
+
+// Contiguous growable column. Used instead of std::vector so that bool
+// columns are real bool arrays that can be viewed without copying.
+template<typename T>
+class Column {
+private:
+    std::unique_ptr<T[]> data_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+
+public:
+    void reserve(std::size_t n) {
+        if (n <= capacity_) return;
+        std::unique_ptr<T[]> grown(new T[n]);
+        for (std::size_t i = 0; i < size_; ++i) grown[i] = std::move(data_[i]);
+        data_ = std::move(grown);
+        capacity_ = n;
+    }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) reserve(capacity_ ? capacity_ * 2 : 16);
+        data_[size_++] = value;
+    }
+
+    void clear() { size_ = 0; }
+    std::size_t size() const { return size_; }
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    HistoryView<T> view() const { return HistoryView<T>(data_.get(), size_); }
+};
+
+// Fixed-capacity ring of the last capacity() logged values
+template<typename T>
+class LagBuffer {
+private:
+    std::unique_ptr<T[]> data_;
+    std::size_t capacity_ = 0;
+    std::size_t next_ = 0;  // Slot the next value is written to
+
+public:
+    void allocate(std::size_t capacity) {
+        data_.reset(capacity ? new T[capacity]() : nullptr);
+        capacity_ = capacity;
+        next_ = 0;
+    }
+
+    void push(const T& value) {
+        data_[next_] = value;
+        if (++next_ == capacity_) next_ = 0;
+    }
+
+    void clear() { next_ = 0; }
+    std::size_t capacity() const { return capacity_; }
+
+    // Value pushed lag pushes ago, 1 <= lag <= capacity(); the caller checks
+    // that at least lag values were pushed since the last clear()
+    const T& back(std::size_t lag) const {
+        return data_[next_ >= lag ? next_ - lag : next_ + capacity_ - lag];
+    }
+};
+
+// Maps variable names to typed storage slots. Built once and shared by every
+// subsimulation so names are never resolved inside the step loop.
+class VariableLayout {
+public:
+    struct Slot {
+        ValueKind kind;
+        int index;  // position among the variables of the same kind
+        int lookback;
+    };
+
+    explicit VariableLayout(const std::vector<Variable>& vars);
+
+    const std::vector<Variable>& variables() const { return variables_; }
+    int size() const { return static_cast<int>(variables_.size()); }
+    int count(ValueKind kind) const { return counts_[static_cast<int>(kind)]; }
+
+    // Variable id for a name, throws if the name is unknown
+    int id(const std::string& name) const;
+    const Slot& slot(int id) const { return slots_[id]; }
+
+    // Typed slot for a name, throws if the name is unknown or of another type
+    template<typename T>
+    int typedSlot(const std::string& name) const;
+
+    template<typename T>
+    VarHandle<T> handle(const std::string& name) const;
+
+private:
+    std::vector<Variable> variables_;
+    std::vector<Slot> slots_;
+    std::unordered_map<std::string, int> ids_;
+    int counts_[4] = {0, 0, 0, 0};
 };
 
 class Context {
@@ -36,21 +181,56 @@ private:
 
 public:
     Context(SubSimulationEnv* e, bool ro = false) : env(e), readonly(ro) {}
-    
+
     template<typename T>
     void setState(const std::string& name, const T& value);
-    
+
     template<typename T>
     T getState(const std::string& name) const;
-    
-    std::shared_ptr<Context> past(int n) const;
-    
+
+    // Fast path: indexed access through a handle resolved up front
+    template<typename T>
+    void set(VarHandle<T> var, const typename VarHandle<T>::value_type& value);
+
+    template<typename T>
+    const T& get(VarHandle<T> var) const;
+
+    // State as logged n steps ago: past(1) is the last logged step, which is
+    // the state a step callback starts from. Reads the recorded history, or
+    // the lookback buffer of a variable declared with lookback >= n when no
+    // history is recorded. Nothing is allocated.
+    PastState past(int n) const;
+
+    // Coordinate dim of this subsimulation's point from the sampler set with
+    // MonteCarloSimulationEnv::set_sampler, in (0, 1). Every step of a path
+    // sees the same point, so give each step its own coordinates.
+    double uniform(int dim) const;
+
+    // Random stream of the current callback, keyed by (seed, subsimulation,
+    // step): every path draws the same numbers whichever thread runs it and
+    // however many draws earlier steps made. Use fill_uniform / fill_normal
+    // for batches.
+    PhiloxStream& rng();
+
+    // Variance-reduction hooks, see MonteCarloSimulationEnv::set_strata.
+    // This path's stratum h of strata() equal-probability strata, and a
+    // uniform drawn from rng() within [h / strata(), (h + 1) / strata()).
+    int stratum() const;
+    int strata() const;
+    double stratified_uniform();
+
+    // Importance sampling: multiply the path's likelihood ratio (nominal
+    // density over sampling density) by ratio. Estimates weight each path
+    // by its ratio, which starts at 1 for every path.
+    void scale_weight(double ratio);
+    double weight() const;
+
     template<typename T>
     void setAuxiliary(const std::string& name, const T& value) {
         if (readonly) throw std::runtime_error("Context is read-only");
         auxiliary[name] = value;
     }
-    
+
     template<typename T>
     T getAuxiliary(const std::string& name) const {
         auto it = auxiliary.find(name);
@@ -59,14 +239,79 @@ public:
     }
 };
 
+// Read-only state of a path n logged steps ago, see Context::past
+class PastState {
+private:
+    const SubSimulationEnv* env;
+    std::size_t lag;
+
+public:
+    PastState(const SubSimulationEnv* e, std::size_t n) : env(e), lag(n) {}
+
+    template<typename T>
+    const T& get(VarHandle<T> var) const;
+
+    template<typename T>
+    T getState(const std::string& name) const;
+};
+
+// Runs a pair of std::function callbacks as a model (see
+// SubSimulationEnv::runModel); every call goes through type erasure
+struct FunctionModel {
+    const std::function<void(Context&)>& begin_fn;
+    const std::function<void(Context&, int)>& step_fn;
+
+    void begin(Context& context) { begin_fn(context); }
+    void step(Context& context, int step) { step_fn(context, step); }
+};
+
 class SubSimulationEnv {
 private:
-    std::vector<Variable> variables;
-    std::map<std::string, std::vector<ValueType>> history;
-    std::map<std::string, ValueType> current_states;
+    // Current values, per-variable history columns and, without history,
+    // lookback buffers for one value kind
+    template<typename T>
+    struct TypedStates {
+        std::unique_ptr<T[]> current;
+        std::vector<Column<T>> history;
+        std::vector<LagBuffer<T>> lagged;
+        std::vector<int> lagged_slots;  // Slots with a lookback buffer
+
+        void init(int n) {
+            current.reset(new T[n]());
+            history.resize(n);
+            lagged.resize(n);
+        }
+        void setLookback(int slot, int lookback) {
+            lagged[slot].allocate(static_cast<std::size_t>(lookback));
+            lagged_slots.push_back(slot);
+        }
+        void reserve(std::size_t steps) {
+            for (auto& column : history) column.reserve(steps);
+        }
+        void log() {
+            for (std::size_t i = 0; i < history.size(); ++i) history[i].push_back(current[i]);
+        }
+        void logLagged() {
+            for (int slot : lagged_slots) lagged[slot].push(current[slot]);
+        }
+        void clear() {
+            for (auto& column : history) column.clear();
+            for (int slot : lagged_slots) lagged[slot].clear();
+        }
+    };
+
+    std::shared_ptr<const VariableLayout> layout;
+    std::tuple<TypedStates<int>, TypedStates<double>, TypedStates<bool>, TypedStates<std::string>> states;
     std::function<void(Context&)> begin_function;
     std::function<void(Context&, int)> step_function;
     int steps_taken;
+    bool record_history;
+    bool has_lookback = false;         // Some variable keeps a lookback buffer instead
+    std::vector<double> sample_point;  // Sampler point of the current path; empty without one
+    PhiloxStream random;               // Stream id = subsimulation; repositioned per callback
+    int path_stratum = 0;
+    int path_strata = 1;
+    double path_weight = 1.0;          // Likelihood ratio of the path, reset by runSteps
 
 public:
     SubSimulationEnv(
@@ -75,53 +320,230 @@ public:
         std::function<void(Context&, int)> step_fn
     );
 
+    // Share a prebuilt layout; expected_steps preallocates the history columns.
+    // With record=false no history is kept: only the current state exists,
+    // plus the last `lookback` values of variables that declare one.
+    SubSimulationEnv(
+        std::shared_ptr<const VariableLayout> var_layout,
+        std::function<void(Context&)> begin_fn,
+        std::function<void(Context&, int)> step_fn,
+        int expected_steps = 0,
+        bool record = true
+    );
+
+    SubSimulationEnv(const SubSimulationEnv&) = delete;
+    SubSimulationEnv& operator=(const SubSimulationEnv&) = delete;
+
     void runSteps(int n);
 
+    // Run n steps, calling observer(*this, step) after each one
+    template<typename Observer>
+    void runSteps(int n, Observer&& observer);
+
+    // As runSteps, with model.begin(Context&) and model.step(Context&, int)
+    // in place of the stored callbacks. The calls are resolved at compile
+    // time, so small step bodies inline into the step loop.
+    template<typename Model, typename Observer>
+    void runModel(Model& model, int n, Observer&& observer);
+
+    // Restore default values and drop recorded history so the env can be reused
+    void reset();
+
+    // Current value of a variable
+    template<typename T>
+    const T& value(VarHandle<T> var) const { return typed<T>().current[var.slot]; }
+
+    int stepsTaken() const { return steps_taken; }
+
+    // Point the next paths read through Context::uniform; copied, so the
+    // caller's buffer may be reused. dims = 0 removes it.
+    void setSamplePoint(const double* point, int dims) { sample_point.assign(point, point + dims); }
+
+    // Key of the random streams Context::rng hands out on this env; an
+    // antithetic env draws the mirror image of the same stream
+    void setRandomKey(std::uint64_t seed, std::uint64_t subsim, bool antithetic = false) {
+        random = PhiloxStream(seed, subsim);
+        random.setAntithetic(antithetic);
+    }
+
+    void setStratum(int stratum, int strata) {
+        path_stratum = stratum;
+        path_strata = strata;
+    }
+
+    // Likelihood ratio of the last path run
+    double weight() const { return path_weight; }
+
+    // Stream positions: step s draws from block s << 32 onwards, the begin
+    // callback before step s from the same with the top bit set
+    static std::uint64_t stepPosition(int step) { return static_cast<std::uint64_t>(step) << 32; }
+    static std::uint64_t beginPosition(int step) { return stepPosition(step) | (1ull << 63); }
+
+    // For paths advanced outside the env (PathBlock lanes). recordValue sets
+    // the current value and logs it as the variable's next step; once every
+    // variable has its steps, advanceSteps counts them.
+    template<typename T>
+    void setValue(VarHandle<T> var, const T& value) { typed<T>().current[var.slot] = value; }
+    template<typename T>
+    void recordValue(VarHandle<T> var, const T& value) {
+        auto& kind = typed<T>();
+        kind.current[var.slot] = value;
+        if (record_history) kind.history[var.slot].push_back(value);
+        else if (kind.lagged[var.slot].capacity() > 0) kind.lagged[var.slot].push(value);
+    }
+    void advanceSteps(int n) { steps_taken += n; }
+    void setWeight(double weight) { path_weight = weight; }
+
+    template<typename T>
+    VarHandle<T> handle(const std::string& var_name) const { return layout->handle<T>(var_name); }
+
     // Get the history of a specific variable
     template<typename T>
-    std::vector<T> getVariableHistory(const std::string& var_name) const;
+    HistoryView<T> getVariableHistory(const std::string& var_name) const;
+
+    template<typename T>
+    HistoryView<T> history(VarHandle<T> var) const { return typed<T>().history[var.slot].view(); }
 
 private:
+    void initStates(int expected_steps);
+    void resetStates();
+    void reserveHistory(std::size_t n);
     void logStates();
+    void logLagged();
+
+    template<typename T>
+    TypedStates<T>& typed() { return std::get<TypedStates<T>>(states); }
+
+    template<typename T>
+    const TypedStates<T>& typed() const { return std::get<TypedStates<T>>(states); }
 
     friend class Context;
+    friend class PastState;
 };
 
+// Implementation of VariableLayout methods
+template<typename T>
+int VariableLayout::typedSlot(const std::string& name) const {
+    const Slot& s = slots_[id(name)];
+    if (s.kind != ValueKindOf<T>::value)
+        throw std::runtime_error("Type mismatch for variable " + name);
+    return s.index;
+}
+
+template<typename T>
+VarHandle<T> VariableLayout::handle(const std::string& name) const {
+    VarHandle<T> h;
+    h.slot = typedSlot<T>(name);
+    h.id = id(name);
+    return h;
+}
+
 // Implementation of Context methods
 template<typename T>
 void Context::setState(const std::string& name, const T& value) {
     if (readonly) throw std::runtime_error("Context is read-only");
-    env->current_states[name] = value;
+    env->typed<T>().current[env->layout->typedSlot<T>(name)] = value;
 }
 
 template<typename T>
 T Context::getState(const std::string& name) const {
-    auto it = env->current_states.find(name);
-    if (it == env->current_states.end()) 
-        throw std::runtime_error("State not found");
-    return std::get<T>(it->second);
+    return env->typed<T>().current[env->layout->typedSlot<T>(name)];
+}
+
+template<typename T>
+void Context::set(VarHandle<T> var, const typename VarHandle<T>::value_type& value) {
+    if (readonly) throw std::runtime_error("Context is read-only");
+    env->typed<T>().current[var.slot] = value;
+}
+
+template<typename T>
+const T& Context::get(VarHandle<T> var) const {
+    return env->typed<T>().current[var.slot];
 }
 
-inline std::shared_ptr<Context> Context::past(int n) const {
+inline PastState Context::past(int n) const {
     if (n < 1 || n > env->steps_taken)
         throw std::runtime_error("Invalid step number");
+    return PastState(env, static_cast<std::size_t>(n));
+}
 
-    // For simplicity, return a read-only context with no past functionality
-    auto context = std::make_shared<Context>(env, true);
-    return context;
+// Implementation of PastState methods
+template<typename T>
+const T& PastState::get(VarHandle<T> var) const {
+    const auto& kind = env->typed<T>();
+    if (env->record_history) {
+        const auto& column = kind.history[var.slot];
+        return column[column.size() - lag];
+    }
+    const auto& buffer = kind.lagged[var.slot];
+    if (lag > buffer.capacity())
+        throw std::out_of_range("Lag " + std::to_string(lag) + " beyond the declared lookback of " +
+                                env->layout->variables()[var.id].name);
+    return buffer.back(lag);
 }
 
-// Implementation of SubSimulationEnv methods
 template<typename T>
-std::vector<T> SubSimulationEnv::getVariableHistory(const std::string& var_name) const {
-    auto it = history.find(var_name);
-    if (it == history.end())
-        throw std::runtime_error("Variable not found");
-
-    std::vector<T> result;
-    for (const auto& value : it->second) {
-        result.push_back(std::get<T>(value));
+T PastState::getState(const std::string& name) const {
+    return get(env->layout->handle<T>(name));
+}
+
+inline double Context::uniform(int dim) const {
+    if (dim < 0 || dim >= static_cast<int>(env->sample_point.size()))
+        throw std::out_of_range(env->sample_point.empty()
+            ? "No sampler point; call set_sampler before run"
+            : "Sampler dimension " + std::to_string(dim) + " out of range");
+    return env->sample_point[dim];
+}
+
+inline PhiloxStream& Context::rng() {
+    if (readonly) throw std::runtime_error("Context is read-only");
+    return env->random;
+}
+
+inline int Context::stratum() const { return env->path_stratum; }
+inline int Context::strata() const { return env->path_strata; }
+
+inline double Context::stratified_uniform() {
+    return (env->path_stratum + rng().uniform()) / env->path_strata;
+}
+
+inline void Context::scale_weight(double ratio) {
+    if (readonly) throw std::runtime_error("Context is read-only");
+    env->path_weight *= ratio;
+}
+
+inline double Context::weight() const { return env->path_weight; }
+
+// Implementation of SubSimulationEnv methods
+template<typename Observer>
+void SubSimulationEnv::runSteps(int n, Observer&& observer) {
+    FunctionModel model{begin_function, step_function};
+    runModel(model, n, std::forward<Observer>(observer));
+}
+
+template<typename Model, typename Observer>
+void SubSimulationEnv::runModel(Model& model, int n, Observer&& observer) {
+    if (n <= 0) throw std::invalid_argument("Steps must be positive");
+
+    // Size every column once so logging never reallocates
+    if (record_history) reserveHistory(static_cast<std::size_t>(steps_taken) + n);
+
+    Context context(this);
+    path_weight = 1.0;
+    random.seek(beginPosition(steps_taken));
+    model.begin(context);
+
+    for (int step = 0; step < n; ++step) {
+        random.seek(stepPosition(steps_taken));
+        model.step(context, step);
+        if (record_history) logStates();
+        else if (has_lookback) logLagged();
+        steps_taken++;
+        observer(static_cast<const SubSimulationEnv&>(*this), step);
     }
-    return result;
 }
 
+template<typename T>
+HistoryView<T> SubSimulationEnv::getVariableHistory(const std::string& var_name) const {
+    return typed<T>().history[layout->typedSlot<T>(var_name)].view();
+}
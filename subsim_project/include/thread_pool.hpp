@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent work-stealing thread pool.
+//
+// parallel_for splits [0, n) into chunks and deals a contiguous run of chunks
+// to every worker. A worker pops chunks from the front of its own run and,
+// once that is empty, steals the back half of the busiest victim's run. The
+// threads live as long as the pool, so repeated runs pay no creation cost.
+class ThreadPool {
+public:
+    // Range callback: fn(begin, end, worker_index)
+    using RangeFunction = std::function<void(std::size_t, std::size_t, int)>;
+
+    explicit ThreadPool(int n_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    // Run fn over [0, n) in chunks of chunk_size and block until done.
+    // The first exception thrown by fn is rethrown on the calling thread.
+    void parallel_for(std::size_t n, std::size_t chunk_size, const RangeFunction& fn);
+
+private:
+    // Each worker's pending chunk run [head, tail) packed into one word so
+    // that the owner's pop and a thief's steal are both a single CAS.
+    struct alignas(64) WorkRange {
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    static std::uint64_t pack(std::uint32_t head, std::uint32_t tail) {
+        return (static_cast<std::uint64_t>(head) << 32) | tail;
+    }
+    static std::uint32_t head_of(std::uint64_t r) { return static_cast<std::uint32_t>(r >> 32); }
+    static std::uint32_t tail_of(std::uint64_t r) { return static_cast<std::uint32_t>(r); }
+
+    void worker_loop(int index);
+    void run_job(int index);
+    bool pop_local(int index, std::uint32_t& chunk);
+    bool steal(int index);
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<WorkRange[]> ranges_;
+
+    std::mutex job_mutex_;      // serialises parallel_for callers
+    std::mutex state_mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::uint64_t generation_ = 0;
+    int active_workers_ = 0;
+    bool stopping_ = false;
+
+    // Current job, valid while active_workers_ > 0
+    const RangeFunction* job_fn_ = nullptr;
+    std::size_t job_n_ = 0;
+    std::size_t job_chunk_ = 1;
+    std::uint32_t job_chunks_ = 0;
+    std::exception_ptr job_error_;
+    std::atomic<bool> job_failed_{false};
+};
@@ -0,0 +1,136 @@
+#include "../include/montecarlo.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Per-step cost of the subsimulation engine, with the step called through
+// the std::function callbacks, a statically dispatched model and a vector
+// model over blocks of 256 lanes, with histories stored and streamed. Two
+// step bodies: the Brownian step of example.cpp, and a deterministic drift
+// whose cost is almost all engine.
+//
+// Usage: subsim_benchmark [n_subsimulations] [n_steps] [n_threads]
+
+namespace {
+
+struct Brownian {
+    VarHandle<double> position;
+    VarHandle<double> velocity;
+
+    void begin(Context& ctx) {
+        ctx.set(position, 0.0);
+        ctx.set(velocity, 1.0);
+    }
+
+    void step(Context& ctx, int) {
+        const double dt = 0.1;
+        double noisy_vel = ctx.get(velocity) + 0.1 * ctx.rng().normal();
+        ctx.set(position, ctx.get(position) + noisy_vel * dt);
+    }
+};
+
+struct Drift {
+    VarHandle<double> position;
+    VarHandle<double> velocity;
+
+    void begin(Context& ctx) {
+        ctx.set(position, 0.0);
+        ctx.set(velocity, 1.0);
+    }
+
+    void step(Context& ctx, int step) {
+        const double dt = 0.1;
+        ctx.set(position, ctx.get(position) + (ctx.get(velocity) + 0.001 * step) * dt);
+    }
+};
+
+// The same steps over PathBlock columns
+struct BrownianLanes {
+    VarHandle<double> position;
+    VarHandle<double> velocity;
+    std::vector<double> noise;
+
+    void begin(PathBlock& block) {
+        std::fill_n(block.column(position), block.size(), 0.0);
+        std::fill_n(block.column(velocity), block.size(), 1.0);
+    }
+
+    void step(PathBlock& block, int) {
+        const double dt = 0.1;
+        const std::size_t n = block.size();
+        noise.resize(n);
+        block.fill_normal(noise.data());
+        double* x = block.column(position);
+        const double* v = block.column(velocity);
+        for (std::size_t l = 0; l < n; ++l) x[l] += (v[l] + 0.1 * noise[l]) * dt;
+    }
+};
+
+struct DriftLanes {
+    VarHandle<double> position;
+    VarHandle<double> velocity;
+    std::vector<double> noise;
+
+    void begin(PathBlock& block) {
+        std::fill_n(block.column(position), block.size(), 0.0);
+        std::fill_n(block.column(velocity), block.size(), 1.0);
+    }
+
+    void step(PathBlock& block, int step) {
+        const double dt = 0.1;
+        const std::size_t n = block.size();
+        double* x = block.column(position);
+        const double* v = block.column(velocity);
+        for (std::size_t l = 0; l < n; ++l) x[l] += (v[l] + 0.001 * step) * dt;
+    }
+};
+
+double time_run(MonteCarloSimulationEnv& env) {
+    env.run(false);  // Warm-up: thread start, page faults
+    auto start = std::chrono::steady_clock::now();
+    env.run(false);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename Kernel, typename Lanes>
+void benchmark(const char* name, int n_subsims, int n_steps, int n_threads) {
+    const double path_steps = static_cast<double>(n_subsims) * n_steps;
+    const char* dispatch_names[] = {"std::function", "model", "lanes"};
+    for (bool streaming : {false, true}) {
+        for (int dispatch = 0; dispatch < 3; ++dispatch) {
+            MonteCarloSimulationEnv env({Variable("position", 0.0), Variable("velocity", 0.0)},
+                                        n_subsims, n_steps, n_threads);
+            env.set_seed(1);
+            Kernel kernel{env.handle<double>("position"), env.handle<double>("velocity")};
+            if (dispatch == 2) {
+                env.set_vector_model(Lanes{kernel.position, kernel.velocity, {}}, 256);
+            } else if (dispatch == 1) {
+                env.set_model(kernel);
+            } else {
+                env.set_subsim_begin_callback([kernel](Context& ctx) mutable { kernel.begin(ctx); });
+                env.set_subsim_step_callback([kernel](Context& ctx, int step) mutable { kernel.step(ctx, step); });
+            }
+            if (streaming) env.stream_variable("position");
+
+            double seconds = time_run(env);
+            std::printf("%-10s %-14s %-10s %10.2f %14.3g\n", name, dispatch_names[dispatch],
+                        streaming ? "streamed" : "stored", seconds * 1e9 / path_steps, path_steps / seconds);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int n_subsims = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int n_steps = argc > 2 ? std::atoi(argv[2]) : 250;
+    const int n_threads = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    std::printf("%d paths x %d steps\n", n_subsims, n_steps);
+    std::printf("%-10s %-14s %-10s %10s %14s\n", "step", "dispatch", "storage", "ns/step", "path-steps/s");
+    benchmark<Brownian, BrownianLanes>("brownian", n_subsims, n_steps, n_threads);
+    benchmark<Drift, DriftLanes>("drift", n_subsims, n_steps, n_threads);
+    return 0;
+}
@@ -1,6 +1,5 @@
 #include "../include/montecarlo.hpp"
 #include <iostream>
-#include <random>
 #include <cmath>
 
 int main() {
@@ -16,29 +15,29 @@ int main() {
         int n_subsimulations = 100; // 100 simulations
         int n_steps = 50;           // 50 steps each
         MonteCarloSimulationEnv mc_env(variables, n_subsimulations, n_steps);
+        mc_env.set_seed(42);  // Same paths on every run, whatever the thread count
+
+        // Resolve variable handles once, outside the callbacks
+        auto position = mc_env.handle<double>("position");
+        auto velocity = mc_env.handle<double>("velocity");
+        auto time = mc_env.handle<double>("time");
 
         // Define begin function
-        mc_env.set_subsim_begin_callback([](Context& ctx) {
-            ctx.setState<double>("position", 0.0);
-            ctx.setState<double>("velocity", 1.0);
-            ctx.setState<double>("time", 0.0);
+        mc_env.set_subsim_begin_callback([=](Context& ctx) {
+            ctx.set(position, 0.0);
+            ctx.set(velocity, 1.0);
+            ctx.set(time, 0.0);
         });
 
         // Define step function with random noise
-        mc_env.set_subsim_step_callback([](Context& ctx, int step) {
-            static thread_local std::mt19937 gen(std::random_device{}());
-            static thread_local std::normal_distribution<> noise(0.0, 0.1);
-
+        mc_env.set_subsim_step_callback([=](Context& ctx, int step) {
             double dt = 0.1;
-            double pos = ctx.getState<double>("position");
-            double vel = ctx.getState<double>("velocity");
-            double time = ctx.getState<double>("time");
 
-            // Add random noise to velocity
-            double noisy_vel = vel + noise(gen);
+            // Add random noise to velocity, drawn from this path's stream
+            double noisy_vel = ctx.get(velocity) + 0.1 * ctx.rng().normal();
 
-            ctx.setState<double>("position", pos + noisy_vel * dt);
-            ctx.setState<double>("time", time + dt);
+            ctx.set(position, ctx.get(position) + noisy_vel * dt);
+            ctx.set(time, ctx.get(time) + dt);
         });
 
         // Run simulations
@@ -5,73 +5,446 @@
 #include <cmath>
 #include <stdexcept>
 #include <limits>
-#include <thread>
 #include <mutex>
+#include <chrono>
 
 MonteCarloSimulationEnv::MonteCarloSimulationEnv(
     const std::vector<Variable>& variables,
     int n_subsimulations,
-    int n_steps
+    int n_steps,
+    int n_threads,
+    int chunk_size
 ) : variables_(variables),
     n_subsims_(n_subsimulations),
-    n_steps_(n_steps) {
+    n_steps_(n_steps),
+    chunk_size_(chunk_size) {
     
     if (n_subsimulations <= 0) 
         throw std::invalid_argument("n_subsimulations must be positive");
     if (n_steps <= 0) 
         throw std::invalid_argument("n_steps must be positive");
+    if (n_threads < 0)
+        throw std::invalid_argument("n_threads must not be negative");
+    if (chunk_size < 0)
+        throw std::invalid_argument("chunk_size must not be negative");
+
+    layout_ = std::make_shared<const VariableLayout>(variables_);
+    pool_ = std::make_unique<ThreadPool>(n_threads);
 }
 
 void MonteCarloSimulationEnv::set_subsim_begin_callback(std::function<void(Context&)> f) {
     begin_function_ = f;
+    model_kernel_ = PathKernel();
 }
 
 void MonteCarloSimulationEnv::set_subsim_step_callback(std::function<void(Context&, int)> f) {
     step_function_ = f;
+    model_kernel_ = PathKernel();
+}
+
+void MonteCarloSimulationEnv::set_sampler(std::shared_ptr<const Sampler> sampler) {
+    sampler_ = std::move(sampler);
+}
+
+void MonteCarloSimulationEnv::fill_sample_points(
+    std::size_t begin, std::size_t end, std::vector<double>& points) const {
+    if (!sampler_) return;
+    points.resize((end - begin) * sampler_->dimensions());
+    sampler_->fill(begin, end - begin, points.data());
+}
+
+void MonteCarloSimulationEnv::set_strata(int n_strata) {
+    if (n_strata < 1) throw std::invalid_argument("n_strata must be positive");
+    n_strata_ = n_strata;
+}
+
+void MonteCarloSimulationEnv::add_control_variate(const std::string& var_name, double expectation) {
+    validate_variable(var_name);
+    if (layout_->slot(layout_->id(var_name)).kind == ValueKind::String)
+        throw std::invalid_argument("Variable " + var_name + " is not numeric");
+    controls_.emplace_back(var_name, expectation);
+}
+
+MonteCarloSimulationEnv::PathKey MonteCarloSimulationEnv::path_key(std::size_t subsim) const {
+    // Antithetic partners share a stream and a stratum
+    const std::size_t unit = antithetic_ ? subsim / 2 : subsim;
+    return {unit, antithetic_ && subsim % 2 == 1, static_cast<int>(unit % n_strata_)};
+}
+
+void MonteCarloSimulationEnv::configure_path(SubSimulationEnv& env, std::size_t subsim) const {
+    const PathKey key = path_key(subsim);
+    env.setRandomKey(seed_, key.stream, key.antithetic);
+    env.setStratum(key.stratum, n_strata_);
+}
+
+void MonteCarloSimulationEnv::stream_variable(const std::string& var_name, const StreamingSpec& spec) {
+    validate_variable(var_name);
+    if (layout_->slot(layout_->id(var_name)).kind == ValueKind::String)
+        throw std::invalid_argument("Variable " + var_name + " is not numeric");
+
+    // Validate the spec now rather than at the start of run()
+    StepAccumulator(1, spec);
+    streaming_specs_[var_name] = spec;
+}
+
+void MonteCarloSimulationEnv::clear_streaming() {
+    streaming_specs_.clear();
+    streaming_results_.clear();
 }
 
 void MonteCarloSimulationEnv::run(bool show_progress) {
-    if (!begin_function_ || !step_function_)
-        throw std::runtime_error("Begin and step functions must be set before running");
+    begin_run();
+    run_batch(0, n_subsims_, default_chunk(n_subsims_), progress_reporter(show_progress), nullptr);
+    end_run(n_subsims_);
+
+    if (show_progress) {
+        std::cout << std::endl << "All simulations completed." << std::endl;
+    }
+}
+
+AdaptiveRunResult MonteCarloSimulationEnv::run_until(const StoppingRule& rule, bool show_progress) {
+    validate_variable(rule.variable);
+    const auto slot = layout_->slot(layout_->id(rule.variable));
+    if (slot.kind == ValueKind::String)
+        throw std::invalid_argument("Variable " + rule.variable + " is not numeric");
+    if (!(rule.target_standard_error > 0.0))
+        throw std::invalid_argument("target_standard_error must be positive");
+    if (rule.batch_size == 0)
+        throw std::invalid_argument("batch_size must be positive");
+
+    const auto start = std::chrono::steady_clock::now();
+    begin_run();
+
+    // Batches hold whole antithetic pairs and whole rounds of strata
+    const std::size_t unit = (antithetic_ ? 2 : 1) * static_cast<std::size_t>(n_strata_);
+    const std::size_t batch = (rule.batch_size + unit - 1) / unit * unit;
+    const std::size_t chunk = default_chunk(batch);
+
+    // Welford accumulators of the weighted final value per worker, one entry
+    // per path or per antithetic pair. Partners are consecutive paths of one
+    // work item, so the first of a pair waits in `pending`.
+    struct WorkerMoments {
+        RunningMoments moments;
+        double pending = 0.0;
+    };
+    std::vector<WorkerMoments> workers(pool_->size());
+    auto on_path = [this, slot, &workers](const SubSimulationEnv& env, std::size_t subsim, int worker) {
+        double x;
+        switch (slot.kind) {
+            case ValueKind::Double: x = env.value(VarHandle<double>{slot.index}); break;
+            case ValueKind::Int: x = env.value(VarHandle<int>{slot.index}); break;
+            default: x = env.value(VarHandle<bool>{slot.index}) ? 1.0 : 0.0; break;
+        }
+        x *= env.weight();
+        WorkerMoments& w = workers[worker];
+        if (!antithetic_) {
+            w.moments.add(x);
+        } else if (subsim % 2 == 0) {
+            w.pending = x;
+        } else {
+            w.moments.add(0.5 * (w.pending + x));
+        }
+    };
+
+    auto report = progress_reporter(show_progress);
+    AdaptiveRunResult result;
+    std::size_t done = 0;
+    while (done < static_cast<std::size_t>(n_subsims_)) {
+        const std::size_t last = std::min<std::size_t>(n_subsims_, done + batch);
+        run_batch(done, last, chunk, report, on_path);
+        done = last;
+
+        RunningMoments total;
+        for (const auto& w : workers) total.merge(w.moments);
+        result.mean = total.mean;
+        result.standard_error = total.count > 1
+            ? std::sqrt(total.m2 / (total.count - 1.0) / total.count)
+            : std::numeric_limits<double>::infinity();
+        if (done >= rule.min_paths && result.standard_error <= rule.target_standard_error) {
+            result.converged = true;
+            break;
+        }
+        if (rule.time_limit.count() > 0 && std::chrono::steady_clock::now() - start >= rule.time_limit) break;
+    }
+    end_run(done);
+
+    result.paths = done;
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    if (show_progress) {
+        std::cout << std::endl << "Stopped after " << done << " of " << n_subsims_ << " simulations." << std::endl;
+    }
+    return result;
+}
+
+std::function<void(std::size_t)> MonteCarloSimulationEnv::progress_reporter(bool show_progress) const {
+    if (!show_progress) return [](std::size_t) {};
+
+    // Progress is reported per chunk rather than per subsimulation
+    struct Progress {
+        std::mutex mutex;
+        std::size_t completed = 0;
+    };
+    auto progress = std::make_shared<Progress>();
+    const int total = n_subsims_;
+    return [progress, total](std::size_t n_done) {
+        std::lock_guard<std::mutex> lock(progress->mutex);
+        progress->completed += n_done;
+        std::cout << "\rCompleted simulation " << progress->completed << " of " << total;
+        std::cout.flush();
+    };
+}
+
+std::size_t MonteCarloSimulationEnv::default_chunk(std::size_t paths) const {
+    // Default to ~8 work items per worker so stealing can balance uneven paths
+    std::size_t chunk = chunk_size_ > 0
+        ? static_cast<std::size_t>(chunk_size_)
+        : std::max<std::size_t>(1, paths / (static_cast<std::size_t>(pool_->size()) * 8));
+    // Antithetic partners stay in one work item, and vector models get
+    // whole blocks of lanes: a multiple of lcm(2, lanes) when both apply
+    std::size_t unit = active_kernel_.lanes > 0 ? active_kernel_.lanes : 1;
+    if (antithetic_ && unit % 2 != 0) unit *= 2;
+    return (chunk + unit - 1) / unit * unit;
+}
+
+void MonteCarloSimulationEnv::begin_run() {
+    if (model_kernel_.run || model_kernel_.block) {
+        active_kernel_ = model_kernel_;
+    } else {
+        if (!begin_function_ || !step_function_)
+            throw std::runtime_error("Begin and step functions must be set before running");
+        // The callbacks, stored in every env, run through the FunctionModel adapter
+        active_kernel_.run = [](SubSimulationEnv& env, int n_steps, int) { env.runSteps(n_steps); };
+        active_kernel_.stream = [](SubSimulationEnv& env, int n_steps, int, const StreamObserver& observe) {
+            env.runSteps(n_steps, observe);
+        };
+    }
+    if (antithetic_ && n_subsims_ % 2 != 0)
+        throw std::runtime_error("Antithetic pairs need an even number of subsimulations");
 
     subsim_envs_.clear();
-    subsim_envs_.resize(n_subsims_);
-
-    // Mutex for thread-safe console output
-    std::mutex cout_mutex;
-
-    // Run simulations in parallel
-    std::vector<std::thread> threads;
-    for (int i = 0; i < n_subsims_; ++i) {
-        threads.emplace_back([this, i, show_progress, &cout_mutex]() {
-            // Create subsimulation environment
-            subsim_envs_[i] = std::make_unique<SubSimulationEnv>(
-                variables_, begin_function_, step_function_
-            );
-
-            // Run steps
-            subsim_envs_[i]->runSteps(n_steps_);
-
-            if (show_progress) {
-                std::lock_guard<std::mutex> lock(cout_mutex);
-                std::cout << "\rCompleted simulation " << i + 1 << " of " << n_subsims_;
-                std::cout.flush();
+    streaming_results_.clear();
+    streaming_targets_.clear();
+    streaming_workers_.clear();
+
+    if (!is_streaming()) {
+        subsim_envs_.resize(n_subsims_);
+        return;
+    }
+
+    for (const auto& [name, spec] : streaming_specs_) {
+        streaming_targets_.push_back({layout_->slot(layout_->id(name)), name});
+    }
+
+    // One accumulator set per worker, merged once at the end
+    streaming_workers_.resize(pool_->size());
+    for (auto& accumulators : streaming_workers_) {
+        for (const auto& [name, spec] : streaming_specs_) {
+            accumulators.emplace_back(n_steps_, spec);
+        }
+    }
+}
+
+void MonteCarloSimulationEnv::run_batch(
+    std::size_t first,
+    std::size_t last,
+    std::size_t chunk,
+    const std::function<void(std::size_t)>& report,
+    const PathCallback& on_path) {
+
+    if (active_kernel_.block) {
+        run_lanes(first, last, chunk, report, on_path);
+        return;
+    }
+
+    if (!is_streaming()) {
+        pool_->parallel_for(last - first, chunk,
+            [this, first, &report, &on_path](std::size_t begin, std::size_t end, int worker) {
+                begin += first;
+                end += first;
+                std::vector<double> points;
+                fill_sample_points(begin, end, points);
+                const int dims = sampler_ ? sampler_->dimensions() : 0;
+
+                for (std::size_t i = begin; i < end; ++i) {
+                    // Create subsimulation environment
+                    subsim_envs_[i] = std::make_unique<SubSimulationEnv>(
+                        layout_, begin_function_, step_function_, n_steps_
+                    );
+                    subsim_envs_[i]->setSamplePoint(points.data() + (i - begin) * dims, dims);
+                    configure_path(*subsim_envs_[i], i);
+
+                    // Run steps
+                    active_kernel_.run(*subsim_envs_[i], n_steps_, worker);
+                    if (on_path) on_path(*subsim_envs_[i], i, worker);
+                }
+                report(end - begin);
+            });
+        return;
+    }
+
+    pool_->parallel_for(last - first, chunk,
+        [this, first, &report, &on_path](std::size_t begin, std::size_t end, int worker) {
+            begin += first;
+            end += first;
+            SubSimulationEnv env(layout_, begin_function_, step_function_, 0, false);
+            StreamObserver observe{&streaming_targets_, &streaming_workers_[worker]};
+            std::vector<double> points;
+            fill_sample_points(begin, end, points);
+            const int dims = sampler_ ? sampler_->dimensions() : 0;
+
+            for (std::size_t i = begin; i < end; ++i) {
+                env.reset();
+                env.setSamplePoint(points.data() + (i - begin) * dims, dims);
+                configure_path(env, i);
+                active_kernel_.stream(env, n_steps_, worker, observe);
+                if (on_path) on_path(env, i, worker);
             }
+            report(end - begin);
         });
+}
+
+namespace {
+
+// Copies lane `lane` of a block into an env's current values
+void copy_lane(const VariableLayout& layout, const PathBlock& block, std::size_t lane, SubSimulationEnv& env) {
+    for (int id = 0; id < layout.size(); ++id) {
+        const auto& slot = layout.slot(id);
+        switch (slot.kind) {
+            case ValueKind::Double: env.setValue(VarHandle<double>{slot.index}, block.column(VarHandle<double>{slot.index})[lane]); break;
+            case ValueKind::Int: env.setValue(VarHandle<int>{slot.index}, block.column(VarHandle<int>{slot.index})[lane]); break;
+            case ValueKind::Bool: env.setValue(VarHandle<bool>{slot.index}, block.column(VarHandle<bool>{slot.index})[lane]); break;
+            case ValueKind::String: break;
+        }
     }
+}
+
+} // namespace
+
+void MonteCarloSimulationEnv::run_lanes(
+    std::size_t first,
+    std::size_t last,
+    std::size_t chunk,
+    const std::function<void(std::size_t)>& report,
+    const PathCallback& on_path) {
+
+    pool_->parallel_for(last - first, chunk,
+        [this, first, &report, &on_path](std::size_t begin, std::size_t end, int worker) {
+            begin += first;
+            end += first;
+            const std::size_t lanes = std::min(active_kernel_.lanes, end - begin);
+            PathBlock block(layout_, lanes);
+            std::vector<double> points;
+            fill_sample_points(begin, end, points);
+            const int dims = sampler_ ? sampler_->dimensions() : 0;
+
+            // Streamed int and bool columns are widened here; a scratch env
+            // stands in for a streamed lane when on_path needs one
+            std::vector<double> widened(lanes);
+            std::unique_ptr<SubSimulationEnv> scratch;
+            if (is_streaming() && on_path)
+                scratch = std::make_unique<SubSimulationEnv>(layout_, begin_function_, step_function_, 0, false);
+
+            for (std::size_t b = begin; b < end; b += lanes) {
+                const std::size_t n = std::min(lanes, end - b);
+                block.start(b, n, seed_);
+                for (std::size_t l = 0; l < n; ++l) {
+                    const PathKey key = path_key(b + l);
+                    block.setPath(l, key.stream, key.antithetic, key.stratum, n_strata_);
+                }
+                block.setSamplePoints(points.data() + (b - begin) * dims, dims);
+
+                BlockObserver observe;
+                if (is_streaming()) {
+                    auto& accumulators = streaming_workers_[worker];
+                    observe = [this, n, &accumulators, &widened](PathBlock& blk, int step) {
+                        for (std::size_t k = 0; k < streaming_targets_.size(); ++k) {
+                            const auto& slot = streaming_targets_[k].slot;
+                            const double* x = widened.data();
+                            switch (slot.kind) {
+                                case ValueKind::Double: x = blk.column(VarHandle<double>{slot.index}); break;
+                                case ValueKind::Int: {
+                                    const int* column = blk.column(VarHandle<int>{slot.index});
+                                    for (std::size_t l = 0; l < n; ++l) widened[l] = column[l];
+                                    break;
+                                }
+                                default: {
+                                    const bool* column = blk.column(VarHandle<bool>{slot.index});
+                                    for (std::size_t l = 0; l < n; ++l) widened[l] = column[l] ? 1.0 : 0.0;
+                                    break;
+                                }
+                            }
+                            accumulators[k].add(step, x, n);
+                        }
+                    };
+                } else {
+                    for (std::size_t l = 0; l < n; ++l) {
+                        subsim_envs_[b + l] = std::make_unique<SubSimulationEnv>(
+                            layout_, begin_function_, step_function_, n_steps_
+                        );
+                    }
+                    // Column by column, so each source column is read once
+                    const auto* envs = &subsim_envs_[b];
+                    observe = [this, envs, n](PathBlock& blk, int) {
+                        auto record = [&](auto var) {
+                            const auto* column = blk.column(var);
+                            for (std::size_t l = 0; l < n; ++l) envs[l]->recordValue(var, column[l]);
+                        };
+                        for (int id = 0; id < layout_->size(); ++id) {
+                            const auto& slot = layout_->slot(id);
+                            switch (slot.kind) {
+                                case ValueKind::Double: record(VarHandle<double>{slot.index}); break;
+                                case ValueKind::Int: record(VarHandle<int>{slot.index}); break;
+                                case ValueKind::Bool: record(VarHandle<bool>{slot.index}); break;
+                                case ValueKind::String: break;
+                            }
+                        }
+                    };
+                }
+
+                active_kernel_.block(block, n_steps_, worker, observe);
+
+                for (std::size_t l = 0; l < n; ++l) {
+                    SubSimulationEnv* env = is_streaming() ? scratch.get() : subsim_envs_[b + l].get();
+                    if (!env) continue;
+                    if (is_streaming()) copy_lane(*layout_, block, l, *env);
+                    else env->advanceSteps(n_steps_);
+                    env->setWeight(block.weights()[l]);
+                    if (on_path) on_path(*env, b + l, worker);
+                }
+            }
+            report(end - begin);
+        });
+}
 
-    // Wait for all simulations to finish
-    for (auto& thread : threads) {
-        thread.join();
+void MonteCarloSimulationEnv::end_run(std::size_t paths) {
+    paths_run_ = paths;
+    if (!is_streaming()) {
+        // Paths past an early stop were never run
+        subsim_envs_.resize(paths);
+        return;
     }
 
-    if (show_progress) {
-        std::cout << std::endl << "All simulations completed." << std::endl;
+    for (std::size_t k = 0; k < streaming_targets_.size(); ++k) {
+        StepAccumulator merged = std::move(streaming_workers_[0][k]);
+        for (std::size_t w = 1; w < streaming_workers_.size(); ++w) {
+            merged.merge(streaming_workers_[w][k]);
+        }
+        streaming_results_.emplace(streaming_targets_[k].name, std::move(merged));
     }
+    streaming_workers_.clear();
+}
+
+StepAccumulator& MonteCarloSimulationEnv::streamed_statistics(const std::string& var_name) {
+    auto it = streaming_results_.find(var_name);
+    if (it == streaming_results_.end())
+        throw std::runtime_error("Variable " + var_name + " was not streamed in the last run");
+    return it->second;
 }
 
 SubSimulationEnv& MonteCarloSimulationEnv::get_subsim_env(int subsim_index) {
-    if (subsim_index >= n_subsims_)
+    if (is_streaming())
+        throw std::runtime_error("Subsimulations are not kept in streaming mode");
+    if (subsim_index < 0 || static_cast<std::size_t>(subsim_index) >= subsim_envs_.size())
         throw std::out_of_range("subsim_index out of range");
     return *subsim_envs_[subsim_index];
 }
@@ -86,91 +459,393 @@ void MonteCarloSimulationEnv::validate_variable(const std::string& var_name) con
 
 std::vector<std::vector<double>> MonteCarloSimulationEnv::collect_histories(
     const std::string& var_name) const {
+    if (is_streaming())
+        throw std::runtime_error("Histories are not stored in streaming mode");
+
     std::vector<std::vector<double>> histories;
     histories.reserve(n_subsims_);
     
     for (const auto& subsim : subsim_envs_) {
-        histories.push_back(subsim->getVariableHistory<double>(var_name));
+        auto history = subsim->getVariableHistory<double>(var_name);
+        histories.emplace_back(history.begin(), history.end());
     }
     
     return histories;
 }
 
-StatisticalResult MonteCarloSimulationEnv::get_variable_mean(
-    const std::string& var_name, 
+namespace {
+
+// q-quantile with linear interpolation between order statistics.
+// Reorders the range; selection instead of a full sort.
+double select_quantile(double* first, double* last, double q) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    double position = std::clamp(q, 0.0, 1.0) * (n - 1);
+    std::size_t k = static_cast<std::size_t>(position);
+    std::nth_element(first, first + k, last);
+    double lower = first[k];
+    if (k + 1 >= n) return lower;
+    double upper = *std::min_element(first + k + 1, last);
+    return lower + (upper - lower) * (position - k);
+}
+
+} // namespace
+
+std::vector<double> MonteCarloSimulationEnv::gather_step_major(const std::string& var_name) const {
+    if (is_streaming())
+        throw std::runtime_error("Histories are not stored in streaming mode");
+
+    const auto& slot = layout_->slot(layout_->id(var_name));
+    if (slot.kind == ValueKind::String)
+        throw std::invalid_argument("Variable " + var_name + " is not numeric");
+
+    // data[step * n_subsims + sim]; transposed in blocks of paths so both the
+    // column reads and the row writes stay within a few cache lines
+    const std::size_t n_sims = subsim_envs_.size();
+    std::vector<double> data(n_sims * n_steps_);
+    constexpr std::size_t block = 64;
+
+    pool_->parallel_for((n_sims + block - 1) / block, 1, [&](std::size_t begin, std::size_t end, int) {
+        for (std::size_t b = begin; b < end; ++b) {
+            std::size_t first = b * block;
+            std::size_t last = std::min(n_sims, first + block);
+            for (std::size_t sim = first; sim < last; ++sim) {
+                const SubSimulationEnv& env = *subsim_envs_[sim];
+                auto scatter = [&](auto history) {
+                    for (int step = 0; step < n_steps_; ++step) {
+                        data[step * n_sims + sim] = static_cast<double>(history[step]);
+                    }
+                };
+                switch (slot.kind) {
+                    case ValueKind::Double: scatter(env.history(VarHandle<double>{slot.index})); break;
+                    case ValueKind::Int: scatter(env.history(VarHandle<int>{slot.index})); break;
+                    default: scatter(env.history(VarHandle<bool>{slot.index})); break;
+                }
+            }
+        }
+    });
+    return data;
+}
+
+VariableStatistics MonteCarloSimulationEnv::get_variable_statistics(
+    const std::string& var_name,
+    unsigned stats,
     const std::string& domain) {
-    
+
     validate_variable(var_name);
-    auto histories = collect_histories(var_name);
-    
-    if (domain == "step") {
-        std::vector<double> means(n_steps_);
+    if (domain != "step")
+        throw std::invalid_argument("Unsupported domain: " + domain);
+
+    std::vector<RunningMoments> moments(n_steps_);
+    std::vector<double> medians;
+    double overall_median = 0.0;
+
+    if (is_streaming()) {
+        auto& streamed = streamed_statistics(var_name);
         for (int step = 0; step < n_steps_; ++step) {
-            double sum = 0.0;
-            for (int sim = 0; sim < n_subsims_; ++sim) {
-                sum += histories[sim][step];
+            moments[step] = streamed.moments(step);
+        }
+        if (stats & STAT_MEDIAN) {
+            if (!(streamed.spec().stats & STREAM_QUANTILES))
+                throw std::runtime_error("Quantiles were not requested for " + var_name);
+            medians.resize(n_steps_);
+            TDigest overall(streamed.spec().compression);
+            for (int step = 0; step < n_steps_; ++step) {
+                medians[step] = streamed.digest(step).quantile(0.5);
+                overall.merge(streamed.digest(step));
             }
-            means[step] = sum / n_subsims_;
+            overall_median = overall.quantile(0.5);
         }
-        
-        double overall = std::accumulate(means.begin(), means.end(), 0.0) / means.size();
-        return StatisticalResult(means, overall);
+    } else {
+        std::vector<double> data = gather_step_major(var_name);
+        const std::size_t n_sims = subsim_envs_.size();
+        if (stats & STAT_MEDIAN) medians.resize(n_steps_);
+
+        // One pass per step row: shifted sums give a stable variance without
+        // Welford's per-element division, and the median is selected while
+        // the row is still in cache
+        pool_->parallel_for(n_steps_, 1, [&](std::size_t begin, std::size_t end, int) {
+            for (std::size_t step = begin; step < end; ++step) {
+                double* row = data.data() + step * n_sims;
+                const double shift = row[0];
+                double s1 = 0.0, s2 = 0.0;
+                double lo = row[0], hi = row[0];
+                for (std::size_t sim = 0; sim < n_sims; ++sim) {
+                    double d = row[sim] - shift;
+                    s1 += d;
+                    s2 += d * d;
+                    lo = std::min(lo, row[sim]);
+                    hi = std::max(hi, row[sim]);
+                }
+
+                RunningMoments& m = moments[step];
+                m.count = n_sims;
+                m.mean = shift + s1 / n_sims;
+                m.m2 = std::max(0.0, s2 - s1 * s1 / n_sims);
+                m.min = lo;
+                m.max = hi;
+
+                if (stats & STAT_MEDIAN) medians[step] = select_quantile(row, row + n_sims, 0.5);
+            }
+        });
+
+        if (stats & STAT_MEDIAN) overall_median = select_quantile(data.data(), data.data() + data.size(), 0.5);
     }
 
-    throw std::invalid_argument("Unsupported domain: " + domain);
+    RunningMoments total;
+    for (const auto& m : moments) total.merge(m);
+
+    VariableStatistics result;
+    auto per_step = [&](unsigned flag, StatisticalResult& out, double overall, auto value) {
+        if (!(stats & flag)) return;
+        out.values.resize(n_steps_);
+        for (int step = 0; step < n_steps_; ++step) out.values[step] = value(moments[step]);
+        out.overall_value = overall;
+    };
+
+    double mean_of_means = 0.0;
+    for (const auto& m : moments) mean_of_means += m.mean;
+    mean_of_means /= n_steps_;
+
+    per_step(STAT_MEAN, result.mean, mean_of_means, [](const RunningMoments& m) { return m.mean; });
+    per_step(STAT_VARIANCE, result.variance, total.variance(), [](const RunningMoments& m) { return m.variance(); });
+    per_step(STAT_STDDEV, result.stddev, std::sqrt(total.variance()),
+        [](const RunningMoments& m) { return std::sqrt(m.variance()); });
+    per_step(STAT_MIN, result.min, total.min, [](const RunningMoments& m) { return m.min; });
+    per_step(STAT_MAX, result.max, total.max, [](const RunningMoments& m) { return m.max; });
+    per_step(STAT_SUM, result.sum, total.sum(), [](const RunningMoments& m) { return m.sum(); });
+    if (stats & STAT_MEDIAN) result.median = StatisticalResult(medians, overall_median);
+
+    return result;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_mean(
+    const std::string& var_name,
+    const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_MEAN, domain).mean;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_median(
+    const std::string& var_name,
+    const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_MEDIAN, domain).median;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_variance(
+    const std::string& var_name,
+    const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_VARIANCE, domain).variance;
 }
 
 StatisticalResult MonteCarloSimulationEnv::get_variable_stddev(
-    const std::string& var_name, 
+    const std::string& var_name,
+    const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_STDDEV, domain).stddev;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_min(
+    const std::string& var_name,
+    const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_MIN, domain).min;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_max(
+    const std::string& var_name,
+    const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_MAX, domain).max;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_sum(
+    const std::string& var_name,
     const std::string& domain) {
+    return get_variable_statistics(var_name, STAT_SUM, domain).sum;
+}
+
+StatisticalResult MonteCarloSimulationEnv::get_variable_quantile(
+    const std::string& var_name,
+    double q) {
 
     validate_variable(var_name);
-    auto histories = collect_histories(var_name);
+    if (!(q >= 0.0 && q <= 1.0))
+        throw std::invalid_argument("Quantile must be in [0, 1]");
+
+    std::vector<double> quantiles(n_steps_);
 
-    if (domain == "step") {
-        std::vector<double> stddevs(n_steps_);
+    if (is_streaming()) {
+        auto& stats = streamed_statistics(var_name);
+        if (!(stats.spec().stats & STREAM_QUANTILES))
+            throw std::runtime_error("Quantiles were not requested for " + var_name);
+
+        TDigest overall(stats.spec().compression);
         for (int step = 0; step < n_steps_; ++step) {
-            double mean = 0.0;
-            for (int sim = 0; sim < n_subsims_; ++sim) {
-                mean += histories[sim][step];
-            }
-            mean /= n_subsims_;
+            quantiles[step] = stats.digest(step).quantile(q);
+            overall.merge(stats.digest(step));
+        }
+        return StatisticalResult(quantiles, overall.quantile(q));
+    }
 
-            double variance = 0.0;
-            for (int sim = 0; sim < n_subsims_; ++sim) {
-                double diff = histories[sim][step] - mean;
-                variance += diff * diff;
-            }
-            variance /= n_subsims_;
-            stddevs[step] = std::sqrt(variance);
+    std::vector<double> data = gather_step_major(var_name);
+    const std::size_t n_sims = subsim_envs_.size();
+    pool_->parallel_for(n_steps_, 1, [&](std::size_t begin, std::size_t end, int) {
+        for (std::size_t step = begin; step < end; ++step) {
+            double* row = data.data() + step * n_sims;
+            quantiles[step] = select_quantile(row, row + n_sims, q);
         }
+    });
+    return StatisticalResult(quantiles, select_quantile(data.data(), data.data() + data.size(), q));
+}
 
-        // Overall stddev
-        double total_mean = 0.0;
-        double total_variance = 0.0;
-        int total_values = n_subsims_ * n_steps_;
-        for (int sim = 0; sim < n_subsims_; ++sim) {
-            for (int step = 0; step < n_steps_; ++step) {
-                total_mean += histories[sim][step];
-            }
+std::vector<double> MonteCarloSimulationEnv::path_values(const std::string& var_name, int step) const {
+    if (is_streaming())
+        throw std::runtime_error("Histories are not stored in streaming mode");
+
+    const auto& slot = layout_->slot(layout_->id(var_name));
+    if (slot.kind == ValueKind::String)
+        throw std::invalid_argument("Variable " + var_name + " is not numeric");
+
+    std::vector<double> values(subsim_envs_.size());
+    for (std::size_t sim = 0; sim < subsim_envs_.size(); ++sim) {
+        const SubSimulationEnv& env = *subsim_envs_[sim];
+        switch (slot.kind) {
+            case ValueKind::Double: values[sim] = env.history(VarHandle<double>{slot.index})[step]; break;
+            case ValueKind::Int: values[sim] = env.history(VarHandle<int>{slot.index})[step]; break;
+            default: values[sim] = env.history(VarHandle<bool>{slot.index})[step] ? 1.0 : 0.0; break;
         }
-        total_mean /= total_values;
-        for (int sim = 0; sim < n_subsims_; ++sim) {
-            for (int step = 0; step < n_steps_; ++step) {
-                double diff = histories[sim][step] - total_mean;
-                total_variance += diff * diff;
-            }
+    }
+    return values;
+}
+
+namespace {
+
+// Solves a x = b in place for a k x k row-major system by Gaussian
+// elimination with partial pivoting; b receives x
+void solve_linear(std::vector<double>& a, std::vector<double>& b, std::size_t k) {
+    for (std::size_t col = 0; col < k; ++col) {
+        std::size_t pivot = col;
+        for (std::size_t row = col + 1; row < k; ++row) {
+            if (std::fabs(a[row * k + col]) > std::fabs(a[pivot * k + col])) pivot = row;
+        }
+        if (std::fabs(a[pivot * k + col]) < 1e-300)
+            throw std::runtime_error("Control variates are constant or collinear");
+        if (pivot != col) {
+            for (std::size_t j = 0; j < k; ++j) std::swap(a[col * k + j], a[pivot * k + j]);
+            std::swap(b[col], b[pivot]);
         }
-        total_variance /= total_values;
-        double overall_stddev = std::sqrt(total_variance);
+        for (std::size_t row = col + 1; row < k; ++row) {
+            double factor = a[row * k + col] / a[col * k + col];
+            for (std::size_t j = col; j < k; ++j) a[row * k + j] -= factor * a[col * k + j];
+            b[row] -= factor * b[col];
+        }
+    }
+    for (std::size_t col = k; col-- > 0;) {
+        for (std::size_t j = col + 1; j < k; ++j) b[col] -= a[col * k + j] * b[j];
+        b[col] /= a[col * k + col];
+    }
+}
+
+} // namespace
 
-        return StatisticalResult(stddevs, overall_stddev);
+MonteCarloEstimate MonteCarloSimulationEnv::get_variable_estimate(const std::string& var_name, int step) {
+    validate_variable(var_name);
+    if (step < 0) step += n_steps_;
+    if (step < 0 || step >= n_steps_)
+        throw std::out_of_range("step out of range");
+
+    const std::vector<double> x = path_values(var_name, step);
+    const std::size_t n = x.size();
+    const std::size_t k = controls_.size();
+    std::vector<std::vector<double>> controls(k);
+    for (std::size_t j = 0; j < k; ++j) controls[j] = path_values(controls_[j].first, step);
+
+    // Importance weights, and the variance of one plain path under the
+    // nominal measure as the yardstick for the effective sample size
+    std::vector<double> w(n);
+    double sw = 0.0, sw2 = 0.0, swx = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        w[i] = subsim_envs_[i]->weight();
+        sw += w[i];
+        sw2 += w[i] * w[i];
+        swx += w[i] * x[i];
+    }
+    if (!(sw > 0.0)) throw std::runtime_error("Importance weights must have a positive sum");
+    const double plain_mean = swx / sw;
+    double plain_variance = 0.0;
+    for (std::size_t i = 0; i < n; ++i) plain_variance += w[i] * (x[i] - plain_mean) * (x[i] - plain_mean);
+    plain_variance = plain_variance / sw * n / (n - 1.0);
+
+    // One unit per path, or per antithetic pair: the weighted value followed
+    // by the weighted controls, averaged over the pair
+    const std::size_t per_unit = antithetic_ ? 2 : 1;
+    const std::size_t m = n / per_unit;
+    const std::size_t dims = k + 1;
+    std::vector<double> units(m * dims, 0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+        double* unit = &units[(i / per_unit) * dims];
+        unit[0] += w[i] * x[i] / per_unit;
+        for (std::size_t j = 0; j < k; ++j) unit[1 + j] += w[i] * controls[j][i] / per_unit;
     }
 
-    throw std::invalid_argument("Unsupported domain: " + domain);
-}
+    // Unit u belongs to stratum u % strata; every column is centred within
+    // its stratum
+    const std::size_t strata = static_cast<std::size_t>(n_strata_);
+    if (m < 2 * strata)
+        throw std::runtime_error("Estimates need at least two paths (or antithetic pairs) per stratum");
+    std::vector<double> means(strata * dims, 0.0);
+    std::vector<double> counts(strata, 0.0);
+    for (std::size_t u = 0; u < m; ++u) {
+        const std::size_t h = u % strata;
+        counts[h] += 1.0;
+        for (std::size_t d = 0; d < dims; ++d) means[h * dims + d] += units[u * dims + d];
+    }
+    for (std::size_t h = 0; h < strata; ++h) {
+        for (std::size_t d = 0; d < dims; ++d) means[h * dims + d] /= counts[h];
+    }
 
-// Implement other statistical methods similarly...
+    // Regression coefficients from the pooled within-stratum covariances
+    MonteCarloEstimate result;
+    if (k > 0) {
+        std::vector<double> cov(dims * dims, 0.0);
+        for (std::size_t u = 0; u < m; ++u) {
+            const double* unit = &units[u * dims];
+            const double* mean = &means[(u % strata) * dims];
+            for (std::size_t a = 0; a < dims; ++a) {
+                for (std::size_t b = 0; b < dims; ++b) cov[a * dims + b] += (unit[a] - mean[a]) * (unit[b] - mean[b]);
+            }
+        }
+        std::vector<double> cc(k * k);
+        std::vector<double> beta(k);
+        for (std::size_t a = 0; a < k; ++a) {
+            for (std::size_t b = 0; b < k; ++b) cc[a * k + b] = cov[(1 + a) * dims + 1 + b];
+            beta[a] = cov[(1 + a) * dims];
+        }
+        solve_linear(cc, beta, k);
+        result.control_coefficients = beta;
+    }
+    const std::vector<double>& beta = result.control_coefficients;
+
+    // Stratified mean and variance of the control-adjusted units
+    std::vector<double> squares(strata, 0.0);
+    for (std::size_t u = 0; u < m; ++u) {
+        const double* unit = &units[u * dims];
+        const double* mean = &means[(u % strata) * dims];
+        double deviation = unit[0] - mean[0];
+        for (std::size_t j = 0; j < k; ++j) deviation -= beta[j] * (unit[1 + j] - mean[1 + j]);
+        squares[u % strata] += deviation * deviation;
+    }
+    double estimate = 0.0, variance = 0.0;
+    for (std::size_t h = 0; h < strata; ++h) {
+        double adjusted = means[h * dims];
+        for (std::size_t j = 0; j < k; ++j) adjusted -= beta[j] * (means[h * dims + 1 + j] - controls_[j].second);
+        estimate += adjusted / strata;
+        variance += squares[h] / (counts[h] - 1.0) / (counts[h] * strata * strata);
+    }
+
+    result.mean = estimate;
+    result.standard_error = std::sqrt(variance);
+    result.paths = n;
+    result.effective_paths = variance > 0.0 ? plain_variance / variance : std::numeric_limits<double>::infinity();
+    result.weight_ess = sw * sw / sw2;
+    return result;
+}
 
 MonteCarloSimulationEnv::HistogramResult MonteCarloSimulationEnv::get_variable_histogram(
     const std::string& var_name,
@@ -179,6 +854,40 @@ MonteCarloSimulationEnv::HistogramResult MonteCarloSimulationEnv::get_variable_h
     std::optional<std::pair<double, double>> range) {
 
     validate_variable(var_name);
+    if (n_bins <= 0)
+        throw std::invalid_argument("n_bins must be positive");
+
+    if (is_streaming()) {
+        auto& stats = streamed_statistics(var_name);
+        const auto& spec = stats.spec();
+        if (!(spec.stats & STREAM_HISTOGRAM))
+            throw std::runtime_error("A histogram was not requested for " + var_name);
+        if (n_bins != spec.n_bins || (range && *range != spec.range))
+            throw std::invalid_argument("Histogram bins must match the streaming spec of " + var_name);
+
+        double bin_width = (spec.range.second - spec.range.first) / n_bins;
+        std::vector<double> bin_edges(n_bins + 1);
+        for (int i = 0; i <= n_bins; ++i) {
+            bin_edges[i] = spec.range.first + i * bin_width;
+        }
+
+        std::vector<std::vector<double>> counts(n_steps_, std::vector<double>(n_bins));
+        for (int step = 0; step < n_steps_; ++step) {
+            const std::uint64_t* step_counts = stats.histogram(step);
+            double total = 0.0;
+            for (int bin = 0; bin < n_bins; ++bin) {
+                counts[step][bin] = static_cast<double>(step_counts[bin]);
+                total += counts[step][bin];
+            }
+            if (density && total > 0.0) {
+                for (double& count : counts[step]) {
+                    count /= (total * bin_width);
+                }
+            }
+        }
+        return HistogramResult{counts, bin_edges};
+    }
+
     auto histories = collect_histories(var_name);
 
     // Find range if not provided
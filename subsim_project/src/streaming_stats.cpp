@@ -0,0 +1,155 @@
+#include "../include/streaming_stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void RunningMoments::add(const double* x, std::size_t n) {
+    if (n == 0) return;
+    RunningMoments block;
+    double sum = 0.0, lo = x[0], hi = x[0];
+    for (std::size_t i = 0; i < n; ++i) {
+        sum += x[i];
+        lo = x[i] < lo ? x[i] : lo;
+        hi = x[i] > hi ? x[i] : hi;
+    }
+    block.count = n;
+    block.mean = sum / static_cast<double>(n);
+    for (std::size_t i = 0; i < n; ++i) block.m2 += (x[i] - block.mean) * (x[i] - block.mean);
+    block.min = lo;
+    block.max = hi;
+    merge(block);
+}
+
+void RunningMoments::merge(const RunningMoments& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+
+    // Chan et al. pairwise update
+    double n_a = static_cast<double>(count);
+    double n_b = static_cast<double>(other.count);
+    double n = n_a + n_b;
+    double delta = other.mean - mean;
+    mean += delta * n_b / n;
+    m2 += other.m2 + delta * delta * n_a * n_b / n;
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+TDigest::TDigest(double compression)
+    : compression_(compression),
+      buffer_limit_(std::max<std::size_t>(1, static_cast<std::size_t>(compression * 5))) {
+    if (compression <= 0.0) throw std::invalid_argument("compression must be positive");
+    buffer_.reserve(buffer_limit_);
+}
+
+void TDigest::add(double x) {
+    min_ = std::min(min_, x);
+    max_ = std::max(max_, x);
+    buffer_.push_back(x);
+    if (buffer_.size() >= buffer_limit_) compress();
+}
+
+void TDigest::merge(const TDigest& other) {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    centroids_.insert(centroids_.end(), other.centroids_.begin(), other.centroids_.end());
+    total_weight_ += other.total_weight_;
+    for (double x : other.buffer_) {
+        centroids_.push_back({x, 1.0});
+        total_weight_ += 1.0;
+    }
+    compress();
+}
+
+void TDigest::compress() {
+    for (double x : buffer_) centroids_.push_back({x, 1.0});
+    total_weight_ += static_cast<double>(buffer_.size());
+    buffer_.clear();
+    if (centroids_.size() < 2) return;
+
+    std::sort(centroids_.begin(), centroids_.end(),
+        [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    // k1 scale function: centroids are small in the tails and large in the middle
+    const double scale = compression_ / (2.0 * M_PI);
+    auto k = [scale](double q) { return scale * std::asin(2.0 * std::min(1.0, q) - 1.0); };
+
+    std::size_t out = 0;
+    double weight_before = 0.0;
+    double k_left = k(0.0);
+    for (std::size_t i = 1; i < centroids_.size(); ++i) {
+        Centroid& current = centroids_[out];
+        const Centroid& next = centroids_[i];
+        double q_right = (weight_before + current.weight + next.weight) / total_weight_;
+        if (k(q_right) - k_left <= 1.0) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            weight_before += current.weight;
+            k_left = k(weight_before / total_weight_);
+            centroids_[++out] = next;
+        }
+    }
+    centroids_.resize(out + 1);
+}
+
+double TDigest::quantile(double q) {
+    if (!buffer_.empty()) compress();
+    if (centroids_.empty()) return std::numeric_limits<double>::quiet_NaN();
+    if (centroids_.size() == 1) return centroids_.front().mean;
+
+    q = std::clamp(q, 0.0, 1.0);
+    double target = q * total_weight_;
+
+    // Each centroid's weight is centred on its mean; interpolate between centres
+    const Centroid& first = centroids_.front();
+    if (target < first.weight / 2.0)
+        return min_ + (first.mean - min_) * target / (first.weight / 2.0);
+
+    double cumulative = first.weight / 2.0;
+    for (std::size_t i = 1; i < centroids_.size(); ++i) {
+        const Centroid& left = centroids_[i - 1];
+        const Centroid& right = centroids_[i];
+        double gap = (left.weight + right.weight) / 2.0;
+        if (target < cumulative + gap)
+            return left.mean + (right.mean - left.mean) * (target - cumulative) / gap;
+        cumulative += gap;
+    }
+
+    const Centroid& last = centroids_.back();
+    double tail = last.weight / 2.0;
+    return last.mean + (max_ - last.mean) * std::min(1.0, (target - cumulative) / tail);
+}
+
+StepAccumulator::StepAccumulator(int n_steps, const StreamingSpec& spec)
+    : spec_(spec), moments_(n_steps) {
+    if (spec.stats & STREAM_HISTOGRAM) {
+        if (spec.n_bins <= 0)
+            throw std::invalid_argument("Streaming histogram needs a positive n_bins");
+        if (!(spec.range.second > spec.range.first))
+            throw std::invalid_argument("Streaming histogram needs a non-empty range");
+        counts_.assign(static_cast<std::size_t>(n_steps) * spec.n_bins, 0);
+    }
+    if (spec.stats & STREAM_QUANTILES) {
+        digests_.assign(n_steps, TDigest(spec.compression));
+    }
+}
+
+void StepAccumulator::addToHistogram(int step, double x) {
+    // Same binning as get_variable_histogram: the upper edge joins the last bin
+    double bin_width = (spec_.range.second - spec_.range.first) / spec_.n_bins;
+    double offset = (x - spec_.range.first) / bin_width;
+    if (!(offset >= 0.0) || offset > spec_.n_bins) return;
+    int bin = std::min(static_cast<int>(offset), spec_.n_bins - 1);
+    counts_[static_cast<std::size_t>(step) * spec_.n_bins + bin]++;
+}
+
+void StepAccumulator::merge(const StepAccumulator& other) {
+    for (std::size_t i = 0; i < moments_.size(); ++i) moments_[i].merge(other.moments_[i]);
+    for (std::size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+    for (std::size_t i = 0; i < digests_.size(); ++i) digests_[i].merge(other.digests_[i]);
+}
@@ -1,38 +1,114 @@
 #include "../include/subsim.hpp"
 
-// SubSimulationEnv constructor
+// VariableLayout constructor
+VariableLayout::VariableLayout(const std::vector<Variable>& vars) : variables_(vars) {
+    slots_.reserve(variables_.size());
+    for (int i = 0; i < static_cast<int>(variables_.size()); ++i) {
+        const auto& var = variables_[i];
+        if (!ids_.emplace(var.name, i).second)
+            throw std::invalid_argument("Duplicate variable " + var.name);
+
+        auto kind = static_cast<ValueKind>(var.default_value.index());
+        if (var.lookback < 0)
+            throw std::invalid_argument("Negative lookback for variable " + var.name);
+        slots_.push_back({kind, counts_[static_cast<int>(kind)]++, var.lookback});
+    }
+}
+
+int VariableLayout::id(const std::string& name) const {
+    auto it = ids_.find(name);
+    if (it == ids_.end())
+        throw std::runtime_error("Variable not found: " + name);
+    return it->second;
+}
+
+// SubSimulationEnv constructors
 SubSimulationEnv::SubSimulationEnv(
     const std::vector<Variable>& vars,
     std::function<void(Context&)> begin_fn,
     std::function<void(Context&, int)> step_fn
-) : variables(vars), 
-    begin_function(begin_fn), 
+) : layout(std::make_shared<const VariableLayout>(vars)),
+    begin_function(begin_fn),
     step_function(step_fn),
-    steps_taken(0) {
+    steps_taken(0),
+    record_history(true) {
+    initStates(0);
+}
+
+SubSimulationEnv::SubSimulationEnv(
+    std::shared_ptr<const VariableLayout> var_layout,
+    std::function<void(Context&)> begin_fn,
+    std::function<void(Context&, int)> step_fn,
+    int expected_steps,
+    bool record
+) : layout(std::move(var_layout)),
+    begin_function(std::move(begin_fn)),
+    step_function(std::move(step_fn)),
+    steps_taken(0),
+    record_history(record) {
+    initStates(expected_steps);
+}
+
+void SubSimulationEnv::initStates(int expected_steps) {
+    typed<int>().init(layout->count(ValueKind::Int));
+    typed<double>().init(layout->count(ValueKind::Double));
+    typed<bool>().init(layout->count(ValueKind::Bool));
+    typed<std::string>().init(layout->count(ValueKind::String));
+
+    // Lookback buffers stand in for the history when none is recorded
+    if (!record_history) {
+        for (int id = 0; id < layout->size(); ++id) {
+            const auto& slot = layout->slot(id);
+            if (slot.lookback == 0) continue;
+            switch (slot.kind) {
+                case ValueKind::Int: typed<int>().setLookback(slot.index, slot.lookback); break;
+                case ValueKind::Double: typed<double>().setLookback(slot.index, slot.lookback); break;
+                case ValueKind::Bool: typed<bool>().setLookback(slot.index, slot.lookback); break;
+                case ValueKind::String: typed<std::string>().setLookback(slot.index, slot.lookback); break;
+            }
+            has_lookback = true;
+        }
+    }
+
+    resetStates();
+
+    if (expected_steps > 0 && record_history) reserveHistory(expected_steps);
+}
+
+void SubSimulationEnv::resetStates() {
     // Initialize states with default values
-    for (const auto& var : variables) {
-        current_states[var.name] = var.default_value;
-        history[var.name] = std::vector<ValueType>();
+    for (int id = 0; id < layout->size(); ++id) {
+        const auto& slot = layout->slot(id);
+        const auto& value = layout->variables()[id].default_value;
+        switch (slot.kind) {
+            case ValueKind::Int: typed<int>().current[slot.index] = std::get<int>(value); break;
+            case ValueKind::Double: typed<double>().current[slot.index] = std::get<double>(value); break;
+            case ValueKind::Bool: typed<bool>().current[slot.index] = std::get<bool>(value); break;
+            case ValueKind::String: typed<std::string>().current[slot.index] = std::get<std::string>(value); break;
+        }
     }
 }
 
+void SubSimulationEnv::reset() {
+    resetStates();
+    std::apply([](auto&... kinds) { (kinds.clear(), ...); }, states);
+    steps_taken = 0;
+}
+
+void SubSimulationEnv::reserveHistory(std::size_t n) {
+    std::apply([n](auto&... kinds) { (kinds.reserve(n), ...); }, states);
+}
+
 void SubSimulationEnv::runSteps(int n) {
-    if (n <= 0) throw std::invalid_argument("Steps must be positive");
-    
-    Context context(this);
-    begin_function(context);
-    
-    for (int step = 0; step < n; ++step) {
-        step_function(context, step);
-        logStates();
-        steps_taken++;
-    }
+    runSteps(n, [](const SubSimulationEnv&, int) {});
 }
 
 void SubSimulationEnv::logStates() {
-    for (const auto& [name, value] : current_states) {
-        history[name].push_back(value);
-    }
+    std::apply([](auto&... kinds) { (kinds.log(), ...); }, states);
+}
+
+void SubSimulationEnv::logLagged() {
+    std::apply([](auto&... kinds) { (kinds.logLagged(), ...); }, states);
 }
 
 // Note: Template methods are defined in the header file (subsim.hpp)
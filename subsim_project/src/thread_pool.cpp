@@ -0,0 +1,145 @@
+#include "../include/thread_pool.hpp"
+#include <algorithm>
+#include <limits>
+
+ThreadPool::ThreadPool(int n_threads) {
+    if (n_threads <= 0)
+        n_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    ranges_ = std::make_unique<WorkRange[]>(n_threads);
+    workers_.reserve(n_threads);
+    for (int i = 0; i < n_threads; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t n, std::size_t chunk_size, const RangeFunction& fn) {
+    if (n == 0) return;
+    if (chunk_size == 0) chunk_size = 1;
+
+    // Chunk indices are 32-bit; grow the chunk for absurdly large ranges
+    const std::size_t max_chunks = std::numeric_limits<std::uint32_t>::max();
+    if ((n + chunk_size - 1) / chunk_size > max_chunks)
+        chunk_size = (n + max_chunks - 1) / max_chunks;
+
+    std::lock_guard<std::mutex> job_lock(job_mutex_);
+
+    const std::uint32_t n_chunks = static_cast<std::uint32_t>((n + chunk_size - 1) / chunk_size);
+    const std::uint32_t n_workers = static_cast<std::uint32_t>(workers_.size());
+
+    // Deal contiguous runs of chunks so neighbouring indices share a worker
+    for (std::uint32_t w = 0; w < n_workers; ++w) {
+        std::uint32_t head = static_cast<std::uint32_t>(static_cast<std::uint64_t>(n_chunks) * w / n_workers);
+        std::uint32_t tail = static_cast<std::uint32_t>(static_cast<std::uint64_t>(n_chunks) * (w + 1) / n_workers);
+        ranges_[w].range.store(pack(head, tail), std::memory_order_relaxed);
+    }
+
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    job_fn_ = &fn;
+    job_n_ = n;
+    job_chunk_ = chunk_size;
+    job_chunks_ = n_chunks;
+    job_error_ = nullptr;
+    job_failed_.store(false, std::memory_order_relaxed);
+    active_workers_ = static_cast<int>(n_workers);
+    ++generation_;
+    work_cv_.notify_all();
+
+    done_cv_.wait(lock, [this]() { return active_workers_ == 0; });
+    job_fn_ = nullptr;
+
+    if (job_error_) std::rethrow_exception(job_error_);
+}
+
+void ThreadPool::worker_loop(int index) {
+    std::uint64_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            work_cv_.wait(lock, [&]() { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) return;
+            seen_generation = generation_;
+        }
+
+        run_job(index);
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (--active_workers_ == 0) done_cv_.notify_one();
+    }
+}
+
+void ThreadPool::run_job(int index) {
+    std::uint32_t chunk;
+    for (;;) {
+        while (pop_local(index, chunk)) {
+            if (job_failed_.load(std::memory_order_relaxed)) continue;
+
+            std::size_t begin = static_cast<std::size_t>(chunk) * job_chunk_;
+            std::size_t end = std::min(job_n_, begin + job_chunk_);
+            try {
+                (*job_fn_)(begin, end, index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                if (!job_error_) job_error_ = std::current_exception();
+                job_failed_.store(true, std::memory_order_relaxed);
+            }
+        }
+        if (!steal(index)) return;
+    }
+}
+
+bool ThreadPool::pop_local(int index, std::uint32_t& chunk) {
+    auto& range = ranges_[index].range;
+    std::uint64_t current = range.load(std::memory_order_acquire);
+    for (;;) {
+        std::uint32_t head = head_of(current);
+        std::uint32_t tail = tail_of(current);
+        if (head >= tail) return false;
+        if (range.compare_exchange_weak(current, pack(head + 1, tail), std::memory_order_acq_rel)) {
+            chunk = head;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(int index) {
+    const int n_workers = size();
+    for (;;) {
+        // Pick the victim with the most chunks left
+        int victim = -1;
+        std::uint64_t victim_range = 0;
+        std::uint32_t most = 0;
+        for (int offset = 1; offset < n_workers; ++offset) {
+            int w = (index + offset) % n_workers;
+            std::uint64_t r = ranges_[w].range.load(std::memory_order_acquire);
+            std::uint32_t left = tail_of(r) > head_of(r) ? tail_of(r) - head_of(r) : 0;
+            if (left > most) {
+                most = left;
+                victim = w;
+                victim_range = r;
+            }
+        }
+        if (victim < 0) return false;
+
+        // Take the back half, leaving the victim the chunks nearest its cursor
+        std::uint32_t head = head_of(victim_range);
+        std::uint32_t tail = tail_of(victim_range);
+        std::uint32_t mid = head + (tail - head) / 2;
+        if (ranges_[victim].range.compare_exchange_strong(
+                victim_range, pack(head, mid), std::memory_order_acq_rel)) {
+            ranges_[index].range.store(pack(mid, tail), std::memory_order_release);
+            return true;
+        }
+    }
+}